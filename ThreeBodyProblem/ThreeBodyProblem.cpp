@@ -1,5 +1,7 @@
 #include "ThreeBodyProblem.h"
 #include <fstream>
+#include <numbers>
+#include <random>
 
 SIM_BEG;
 
@@ -38,7 +40,23 @@ void ThreeBodyProblem_Scene::UI::sidebar()
     if (ImGui::CollapsingHeaderBox("Animation", true))
     {
         bl_scoped(animation_speed);
+        bl_scoped(animation_dir);
+        bl_pull(cur_iter);
+        bl_pull(timeline_len);
+
         ImGui::SliderInt("Animation Speed", &animation_speed, 1, 200);
+
+        if (ImGui::Button("Reverse")) animation_dir = -1;
+        ImGui::SameLine();
+        if (ImGui::Button("Pause")) animation_dir = 0;
+        ImGui::SameLine();
+        if (ImGui::Button("Play")) animation_dir = 1;
+
+        // scrubbing only schedules a seek, stepping happens on the scene thread
+        int seek_iter = cur_iter;
+        if (ImGui::SliderInt("Timeline", &seek_iter, 0, timeline_len))
+            bl_schedule([seek_iter](ThreeBodyProblem_Scene& scene) { scene.seekAnimation(seek_iter); });
+
         ImGui::EndCollapsingHeaderBox();
     }
 
@@ -65,25 +83,373 @@ void ThreeBodyProblem_Scene::UI::sidebar()
         {
             bl_pull(cur_iter);
 
+            bl_pull(index_size);
+            bl_pull(index_hits);
+            bl_pull(index_misses);
+            bl_pull(last_lookup_us);
+
             ImGui::TableNextColumn();
             ImGui::Text("Iteration");
+            ImGui::Text("Indexed results");
+            ImGui::Text("Index hits / misses");
+            ImGui::Text("Last lookup");
+            ImGui::Text("Heap allocations");
+
+            ImGui::TableNextColumn();
             ImGui::Text("%d", cur_iter);
+            ImGui::Text("%d", index_size);
+            ImGui::Text("%d / %d", index_hits, index_misses);
+            ImGui::Text("%.1f us", last_lookup_us);
+
+            // process-wide atomics, safe to read from the UI thread
+            if (AllocCounter::enabled())
+                ImGui::Text("%llu (%.1f MB)", (unsigned long long)AllocCounter::total(), (f64)AllocCounter::bytes() / (1024.0 * 1024.0));
+            else
+                ImGui::Text("off (THREEBODY_COUNT_ALLOCATIONS)");
 
             ImGui::EndTable();
         }
         ImGui::EndCollapsingHeaderBox();
     }
 
+    if (ImGui::CollapsingHeaderBox("Verify"))
+    {
+        bl_pull(precision_report);
+        bl_pull(has_precision_report);
+        bl_pull(precision_running);
+
+        if (precision_running)
+            ImGui::Text("Verifying...");
+        else if (ImGui::Button("Verify Current (double-double)"))
+            bl_schedule([](ThreeBodyProblem_Scene& scene) { scene.verifyCurrentSim(); });
+
+        if (has_precision_report && ImGui::BeginTable("precision_report", 3, ImGuiTableFlags_SizingStretchProp))
+        {
+            const PrecisionReport& r = precision_report;
+
+            ImGui::TableSetupColumn("");
+            ImGui::TableSetupColumn("Base");
+            ImGui::TableSetupColumn("Double-double");
+            ImGui::TableHeadersRow();
+
+            ImGui::TableNextColumn(); ImGui::Text("Outcome");
+            ImGui::TableNextColumn(); ImGui::Text("%s", StopResult::typeName(r.base_result.type));
+            ImGui::TableNextColumn(); ImGui::Text("%s", StopResult::typeName(r.dd_result.type));
+
+            ImGui::TableNextColumn(); ImGui::Text("Iterations");
+            ImGui::TableNextColumn(); ImGui::Text("%d", r.base_iters);
+            ImGui::TableNextColumn(); ImGui::Text("%d", r.dd_iters);
+
+            ImGui::TableNextColumn(); ImGui::Text("Time");
+            ImGui::TableNextColumn(); ImGui::Text("%.1f ms", r.base_ms);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f ms (%.1fx)", r.dd_ms, r.costRatio());
+
+            ImGui::EndTable();
+        }
+
+        if (has_precision_report)
+        {
+            const PrecisionReport& r = precision_report;
+            ImGui::Text("Outcomes %s", r.agrees() ? "agree" : "DIFFER");
+            if (r.split_iter >= 0)
+                ImGui::Text("Trajectories split at iteration %d", r.split_iter);
+            else
+                ImGui::Text("Trajectories never split (max error %.3g)", r.max_pos_err);
+        }
+
+        ImGui::Separator();
+        {
+            bl_scoped(parareal_config);
+            bl_pull(parareal_report);
+            bl_pull(has_parareal_report);
+            bl_pull(parareal_running);
+
+            ImGui::SliderInt("Segments (0 = threads)", &parareal_config.segments, 0, 256);
+            ImGui::SliderInt("Coarse dt factor", &parareal_config.coarse_factor, 2, 64);
+            ImGui::Checkbox("Compare with serial run", &parareal_config.compare_serial);
+
+            if (parareal_running)
+                ImGui::Text("Verifying...");
+            else if (ImGui::Button("Verify Current (Parareal)"))
+                bl_schedule([](ThreeBodyProblem_Scene& scene) { scene.verifyCurrentSimParareal(); });
+
+            if (has_parareal_report)
+            {
+                const PararealReport& r = parareal_report;
+                ImGui::Text("Span: %s after %d iterations (coarse estimate)", StopResult::typeName(r.span_result.type), r.span_iters);
+                ImGui::Text("%d segments, %d iterations (%s, last update %.3g)",
+                    r.segments, r.iterations, r.converged ? "converged" : "not converged", r.last_update);
+                if (r.serial_ms > 0)
+                    ImGui::Text("Parareal %.1f ms (estimate %.1f ms), serial %.1f ms (%.2fx speedup)", r.parareal_ms, r.estimate_ms, r.serial_ms, r.speedup());
+                else
+                    ImGui::Text("Parareal %.1f ms (estimate %.1f ms)", r.parareal_ms, r.estimate_ms);
+                if (r.max_pos_err >= 0)
+                    ImGui::Text("Max boundary error %.3g, final %.3g", r.max_pos_err, r.final_pos_err);
+            }
+        }
+        ImGui::EndCollapsingHeaderBox();
+    }
+
+    if (ImGui::CollapsingHeaderBox("Continuation"))
+    {
+        bl_scoped(continuation_config);
+        bl_scoped(continuation_steps);
+        bl_scoped(branch_selected);
+        bl_pull(branch_points);
+        bl_pull(continuation_failed);
+        bl_pull(continuation_running);
+
+        const char* param_names[] = { "G", "Softening (soft2)", "Body C x", "Body C y" };
+        int param = (int)continuation_config.param;
+        if (ImGui::Combo("Parameter", &param, param_names, IM_ARRAYSIZE(param_names)))
+            continuation_config.param = (ContinuationParam)param;
+
+        ImGui::InputDouble("Step (ds)", &continuation_config.ds, 0.001, 0.01, "%.4f");
+        ImGui::InputDouble("Max step", &continuation_config.ds_max, 0.01, 0.1, "%.4f");
+        ImGui::SliderInt("Steps", &continuation_steps, 1, 200);
+
+        bool reverse = continuation_config.direction < 0;
+        if (ImGui::Checkbox("Decreasing parameter", &reverse))
+            continuation_config.direction = reverse ? -1 : 1;
+
+        if (continuation_running)
+        {
+            ImGui::Text("Continuing...");
+        }
+        else
+        {
+            if (ImGui::Button("Continue Current Orbit"))
+                bl_schedule([](ThreeBodyProblem_Scene& scene) { scene.continueCurrentOrbit(); });
+
+            ImGui::SameLine();
+            if (ImGui::Button("Extend"))
+                bl_schedule([](ThreeBodyProblem_Scene& scene) { scene.extendBranch(); });
+        }
+
+        if (continuation_failed)
+            ImGui::Text("No periodic orbit found from the current sim");
+
+        if (!branch_points.empty())
+        {
+            int folds = 0, branches = 0;
+            for (const BranchPoint& p : branch_points)
+            {
+                if (p.flags & BranchPoint::FLAG_FOLD) folds++;
+                if (p.flags & BranchPoint::FLAG_BRANCH) branches++;
+            }
+            ImGui::Text("%d points, %d folds, %d branch candidates", (int)branch_points.size(), folds, branches);
+
+            branch_selected = std::clamp(branch_selected, 0, (int)branch_points.size() - 1);
+            ImGui::SliderInt("Point", &branch_selected, 0, (int)branch_points.size() - 1);
+
+            const BranchPoint& p = branch_points[branch_selected];
+            ImGui::Text("lambda %.6g, period %.6g, residual %.2g%s%s", p.lambda, p.period, p.residual,
+                (p.flags & BranchPoint::FLAG_FOLD) ? ", fold" : "",
+                (p.flags & BranchPoint::FLAG_BRANCH) ? ", branch?" : "");
+
+            if (ImGui::Button("Show Point"))
+                bl_schedule([i = branch_selected](ThreeBodyProblem_Scene& scene) { scene.showBranchPoint(i); });
+
+            ImGui::SameLine();
+            if (ImGui::Button("Save Branch"))
+                bl_schedule([](ThreeBodyProblem_Scene& scene) { scene.continuation.save("orbit_branch.bin"); });
+        }
+        ImGui::EndCollapsingHeaderBox();
+    }
+
+    if (ImGui::CollapsingHeaderBox("N-Body"))
+    {
+        bl_scoped(nbody_preset);
+        bl_scoped(nbody_force);
+        bl_scoped(nbody_theta);
+        bl_pull(nbody_active);
+        bl_pull(nbody_running);
+        bl_pull(nbody_bodies);
+        bl_pull(nbody_iters);
+        bl_pull(nbody_used);
+        bl_pull(nbody_result);
+        bl_pull(nbody_drift);
+        bl_pull(nbody_ms);
+
+        const char* preset_names[] = {
+            "Pythagorean (3:4:5)",
+            "Hierarchical quadruple",
+            "Restricted: Sun-Jupiter Trojans",
+            "Rotating disc (1024 bodies)"
+        };
+        ImGui::Combo("Preset", &nbody_preset, preset_names, IM_ARRAYSIZE(preset_names));
+
+        const char* force_names[] = {
+            nbodyForceName(NBodyForce::AUTO),
+            nbodyForceName(NBodyForce::DIRECT),
+            nbodyForceName(NBodyForce::TILED),
+            nbodyForceName(NBodyForce::BARNES_HUT)
+        };
+        ImGui::Combo("Forces", &nbody_force, force_names, IM_ARRAYSIZE(force_names));
+
+        if (ImGui::InputDouble("Opening angle", &nbody_theta, 0.05, 0.1, "%.2f"))
+            nbody_theta = std::clamp(nbody_theta, (flt)0.05, (flt)1.5);
+
+        if (nbody_running)
+            ImGui::Text("Integrating...");
+        else if (ImGui::Button("Plot Preset"))
+            bl_schedule([i = nbody_preset](ThreeBodyProblem_Scene& scene) { scene.launchNBodyPreset(i); });
+
+        if (nbody_active)
+        {
+            ImGui::Text("%d bodies, %s", nbody_bodies, nbodyForceName(nbody_used));
+            ImGui::Text("%d iterations (%s) in %.1f ms", nbody_iters, StopResult::typeName(nbody_result.type), nbody_ms);
+            ImGui::Text("Energy drift %.3g", nbody_drift);
+        }
+        ImGui::EndCollapsingHeaderBox();
+    }
+
+    if (ImGui::CollapsingHeaderBox("Kernels"))
+    {
+        bl_scoped(kernel_isa);
+        bl_pull(kernel_stats);
+
+        const char* isa_names[] = {
+            kernelISAName(KernelISA::AUTO),
+            kernelISAName(KernelISA::SSE2),
+            kernelISAName(KernelISA::AVX2),
+            kernelISAName(KernelISA::AVX512)
+        };
+        int isa_index = kernel_isa + 1;
+        if (ImGui::Combo("Kernel ISA", &isa_index, isa_names, IM_ARRAYSIZE(isa_names)))
+            kernel_isa = isa_index - 1;
+
+        if (ImGui::BeginTable("kernel_stats", 2, ImGuiTableFlags_SizingStretchProp))
+        {
+            ImGui::TableNextColumn();
+            ImGui::Text("Active");
+            ImGui::Text("Best supported");
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", kernelISAName(kernel_stats.active));
+            ImGui::Text("%s", kernelISAName(kernel_stats.best));
+
+            ImGui::EndTable();
+        }
+
+        if (ImGui::BeginTable("kernel_variants", 3, ImGuiTableFlags_SizingStretchProp))
+        {
+            ImGui::TableSetupColumn("Variant");
+            ImGui::TableSetupColumn("Sims");
+            ImGui::TableSetupColumn("Lane steps");
+            ImGui::TableHeadersRow();
+
+            for (int i = 0; i < (int)KernelISA::COUNT; i++)
+            {
+                ImGui::TableNextColumn(); ImGui::Text("%s", kernelISAName((KernelISA)i));
+                ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)kernel_stats.sims[i]);
+                ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)kernel_stats.steps[i]);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::EndCollapsingHeaderBox();
+    }
+
     // Screener
     if (ImGui::CollapsingHeaderBox("Screener"))
     {
         bl_pull(results_cstr);
         bl_scoped(selected_result);
 
+        {
+            bl_scoped(scan_res_setting);
+            const char* res_names[] = { "128", "256", "512", "1024", "2048" };
+            int res_index = std::clamp((int)std::log2(scan_res_setting) - 7, 0, 4);
+            if (ImGui::Combo("Resolution", &res_index, res_names, IM_ARRAYSIZE(res_names)))
+                scan_res_setting = 128 << res_index;
+        }
+
+        {
+            bl_scoped(prefilter_unbound);
+            bl_scoped(prefilter_hierarchical);
+            ImGui::Checkbox("Rule out unbound (E >= 0, drops their survival time)", &prefilter_unbound);
+            ImGui::Checkbox("Fast-track stable hierarchies (verified)", &prefilter_hierarchical);
+        }
+
         if (ImGui::Button("Run Screener"))
             bl_schedule([](ThreeBodyProblem_Scene& scene) { scene.beginScan(); });
 
-        if (ImGui::ListBox("Stable Results", &selected_result, results_cstr.data(), (int)results_cstr.size(), 15))
+        {
+            bl_scoped(pin_scan_workers);
+            ImGui::Checkbox("Pin scan workers to CPUs", &pin_scan_workers);
+        }
+
+        {
+            bl_scoped(hover_use_index);
+            ImGui::Checkbox("Hover uses scan results", &hover_use_index);
+        }
+
+        // bypass the index for the last hovered position
+        ImGui::SameLine();
+        if (ImGui::Button("Fresh Sim"))
+        {
+            bl_schedule([](ThreeBodyProblem_Scene& scene) {
+                Sim sim;
+                if (scene.bestSimAt(scene.input_pos, sim, true))
+                    scene.setCurrentSim(sim);
+            });
+        }
+
+        {
+            bl_pull(scan_stats);
+            bl_pull(scan_expected);
+            bl_pull(scan_received);
+            bl_pull(harvest_pending);
+            bl_pull(library_size);
+            bl_pull(harvest_duplicates);
+
+            if (ImGui::BeginTable("scan_stats", 2, ImGuiTableFlags_SizingStretchProp))
+            {
+                ImGui::TableNextColumn();
+                ImGui::Text("Progress");
+                ImGui::Text("Shared workers");
+                ImGui::Text("Queued tiles");
+                ImGui::Text("Pixels computed");
+                ImGui::Text("Deduplicated");
+                ImGui::Text("Diverged sims");
+                ImGui::Text("Pre-filter: ruled out");
+                ImGui::Text("Pre-filter: fast-track skips");
+                ImGui::Text("Worker contexts");
+                ImGui::Text("Pinned workers");
+                ImGui::Text("Allocations / pixel");
+                ImGui::Text("Atomic RMWs / pixel");
+                ImGui::Text("Harvest queue");
+                ImGui::Text("Library orbits");
+                ImGui::Text("Duplicates dropped");
+
+                ImGui::TableNextColumn();
+                ImGui::Text("%d / %d", scan_received, scan_expected);
+                ImGui::Text("%d", scan_stats.workers);
+                ImGui::Text("%d", scan_stats.pending_tiles);
+                ImGui::Text("%llu", (unsigned long long)scan_stats.computed);
+                ImGui::Text("%llu", (unsigned long long)scan_stats.dedup_hits);
+                ImGui::Text("%llu", (unsigned long long)scan_stats.diverged);
+                ImGui::Text("%llu", (unsigned long long)scan_stats.ruled_out);
+                ImGui::Text("%llu", (unsigned long long)scan_stats.fast_tracked);
+                ImGui::Text("%d (%llu KB)", scan_stats.contexts, (unsigned long long)(scan_stats.context_bytes / 1024));
+                ImGui::Text("%d / %d", scan_stats.pinned_workers, scan_stats.workers);
+                if (AllocCounter::enabled() && scan_stats.computed > 0)
+                    ImGui::Text("%.2f", (f64)scan_stats.pixel_allocations / (f64)scan_stats.computed);
+                else
+                    ImGui::Text("-");
+                if (scan_stats.computed > 0)
+                    ImGui::Text("%.2f", (f64)scan_stats.pixel_atomics / (f64)scan_stats.computed);
+                else
+                    ImGui::Text("-");
+                ImGui::Text("%d", harvest_pending);
+                ImGui::Text("%d", library_size);
+                ImGui::Text("%d", harvest_duplicates);
+
+                ImGui::EndTable();
+            }
+        }
+
+        if (ImGui::ListBox("Orbit Library", &selected_result, results_cstr.data(), (int)results_cstr.size(), 15))
             bl_schedule([&](ThreeBodyProblem_Scene& scene) { scene.setCurrentSimFromResult(selected_result); });
 
         if (ImGui::Button("Start"))
@@ -93,12 +459,117 @@ void ThreeBodyProblem_Scene::UI::sidebar()
             bl_schedule([&](ThreeBodyProblem_Scene& scene) { scene.endAnimation(); });
 
         if (ImGui::Button("Save"))
+            bl_schedule([](ThreeBodyProblem_Scene& scene) { scene.orbit_library.save("orbits.lib"); });
+
+        ImGui::SameLine();
+        if (ImGui::Button("Load"))
         {
-            bl_pull(results);
+            bl_schedule([](ThreeBodyProblem_Scene& scene) {
+                scene.orbit_library.load("orbits.lib");
+                scene.refreshResults();
+            });
+        }
+        ImGui::EndCollapsingHeaderBox();
+    }
 
-            std::ofstream out("results.bin", std::ios::binary);
-            out.write((const char*)results.data(), sizeof(Sim)*results.size());
+    if (ImGui::CollapsingHeaderBox("Parameter Sweep"))
+    {
+        bl_scoped(sweep_config);
+        bl_pull(sweep_running);
+        bl_pull(sweep_progress);
+
+        constexpr ImGuiDataType flt_type = std::is_same_v<flt, f32> ? ImGuiDataType_Float : ImGuiDataType_Double;
+        auto axisUI = [&](const char* label, SweepAxis<flt>& axis)
+        {
+            ImGui::PushID(label);
+            ImGui::TextUnformatted(label);
+            ImGui::InputScalar("Min", flt_type, &axis.min);
+            ImGui::InputScalar("Max", flt_type, &axis.max);
+            ImGui::SliderInt("Steps", &axis.steps, 1, 32);
+            ImGui::PopID();
+        };
+
+        axisUI("G", sweep_config.G);
+        axisUI("Max Velocity", sweep_config.max_vel);
+        axisUI("dt", sweep_config.dt);
+
+        ImGui::PushID("iter_lim");
+        ImGui::TextUnformatted("Iteration Limit");
+        ImGui::InputInt("Min", &sweep_config.iter_lim.min);
+        ImGui::InputInt("Max", &sweep_config.iter_lim.max);
+        ImGui::SliderInt("Steps", &sweep_config.iter_lim.steps, 1, 32);
+        ImGui::PopID();
+
+        ImGui::SliderInt("Resolution", &sweep_config.width, 16, 512);
+        sweep_config.height = sweep_config.width;
+
+        if (ImGui::Button(sweep_running ? "Restart Sweep" : "Run Sweep"))
+            bl_schedule([](ThreeBodyProblem_Scene& scene) { scene.startSweep(); });
+
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel"))
+            bl_schedule([](ThreeBodyProblem_Scene& scene) { scene.sweep.cancel(); });
+
+        ImGui::SameLine();
+        if (ImGui::Button("Save Volume"))
+            bl_schedule([](ThreeBodyProblem_Scene& scene) { scene.sweep.save("sweep.bin"); });
+
+        ImGui::ProgressBar(sweep_progress);
+        ImGui::EndCollapsingHeaderBox();
+    }
+
+    if (ImGui::CollapsingHeaderBox("Monte Carlo"))
+    {
+        bl_scoped(mc_config);
+        bl_pull(mc_running);
+        bl_pull(mc_estimate);
+        bl_pull(mc_histogram);
+
+        const char* sampling_names[] = { "Random", "Sobol" };
+        int sampling = (int)mc_config.sampling;
+        if (ImGui::Combo("Sampling", &sampling, sampling_names, IM_ARRAYSIZE(sampling_names)))
+            mc_config.sampling = (MonteCarloSampling)sampling;
+
+        ImGui::InputDouble("Target +/-", &mc_config.target_half_width, 0.001, 0.01, "%.4f");
+        const f64 confidence_min = 0.8, confidence_max = 0.999;
+        ImGui::SliderScalar("Confidence", ImGuiDataType_Double, &mc_config.confidence, &confidence_min, &confidence_max, "%.3f");
+
+        int max_samples = (int)mc_config.max_samples;
+        if (ImGui::InputInt("Max Samples", &max_samples, 1024, 65536))
+            mc_config.max_samples = std::max(max_samples, 1);
+
+        if (ImGui::Button(mc_running ? "Restart Sampling" : "Run Sampling"))
+            bl_schedule([](ThreeBodyProblem_Scene& scene) { scene.startMonteCarlo(); });
+
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel"))
+            bl_schedule([](ThreeBodyProblem_Scene& scene) { scene.monte_carlo.cancel(); });
+
+        const MonteCarlo::Estimate& e = mc_estimate;
+        if (e.samples > 0 && ImGui::BeginTable("mc_estimate", 2, ImGuiTableFlags_SizingStretchProp))
+        {
+            ImGui::TableNextColumn();
+            ImGui::Text("Samples");
+            ImGui::Text("Diverged");
+            ImGui::Text("Survival");
+            ImGui::Text("Interval");
+            ImGui::Text("Mean iterations");
+            ImGui::Text("Status");
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%lld", (long long)e.samples);
+            ImGui::Text("%lld", (long long)e.diverged);
+            ImGui::Text("%.4f", e.survival.p);
+            ImGui::Text("[%.4f, %.4f]", e.survival.lo, e.survival.hi);
+            ImGui::Text("%.0f +/- %.0f", e.mean_iters, e.mean_iters_ci);
+            ImGui::Text("%s", e.converged ? "Converged" : (mc_running ? "Sampling" : "Stopped"));
+
+            ImGui::EndTable();
         }
+
+        if (!mc_histogram.empty())
+            ImGui::PlotHistogram("Escape iterations", mc_histogram.data(), (int)mc_histogram.size(), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 80));
+
         ImGui::EndCollapsingHeaderBox();
     }
 }
@@ -106,6 +577,10 @@ void ThreeBodyProblem_Scene::UI::sidebar()
 void ThreeBodyProblem_Scene::sceneStart()
 {
     /// initialize scene
+    scan_client = ScanService::shared().registerClient();
+
+    orbit_library.load("orbits.lib");
+    refreshResults();
 }
 
 void ThreeBodyProblem_Scene::sceneMounted(Viewport* ctx)
@@ -127,27 +602,177 @@ void ThreeBodyProblem_Scene::sceneMounted(Viewport* ctx)
 void ThreeBodyProblem_Scene::sceneDestroy()
 {
     /// destroy scene (dynamically allocated resources, etc.)
+    ScanService::shared().unregisterClient(scan_client);
+    scan_client = -1;
 }
 
 void ThreeBodyProblem_Scene::sceneProcess()
 {
     /// process scene once each frame (not per viewport)
+
+    setKernelISAOverride((KernelISA)kernel_isa);
+    kernel_stats = KernelStats::snapshot();
+    ScanService::shared().setPinWorkers(pin_scan_workers);
+    scan_stats = ScanService::shared().stats();
+
+    sweep.poll();
+    sweep_running = sweep.running();
+    sweep_progress = sweep.progress();
+
+    if (monte_carlo.poll())
+    {
+        mc_estimate = monte_carlo.estimate();
+        mc_histogram.assign(mc_estimate.escape_histogram.begin(), mc_estimate.escape_histogram.end());
+    }
+    mc_running = monte_carlo.running();
+
+    processHarvest();
+    pollPrecision();
+    pollParareal();
+    pollContinuation();
+    pollNBody();
     
     if (playingAnimation())
+    {
+        stepAnimation();
+        cur_iter = sim_animation.curIter();
+    }
+}
+
+void ThreeBodyProblem_Scene::stepAnimation()
+{
+    if (animation_dir > 0)
     {
         for (int i = 0; i < animation_speed; i++)
-            sim_animation.progress(env);
+            sim_animation.progress(current_env);
+    }
+    else if (animation_dir < 0)
+    {
+        for (int i = 0; i < animation_speed && sim_animation.curIter() > 0; i++)
+        {
+            sim_animation.regress(current_env);
 
-        cur_iter = sim_animation.curIter();
+            // snap to keyframes to discard rounding picked up while reversing
+            current_keyframes.restore(sim_animation.curIter(), sim_animation);
+        }
+    }
+}
+
+void ThreeBodyProblem_Scene::seekAnimation(int iter)
+{
+    if (current_keyframes.empty())
+        return;
+
+    if (!playingAnimation())
+    {
+        startAnimation();
+        animation_dir = 0;
     }
+
+    current_keyframes.seek(current_env, iter, sim_animation);
+    cur_iter = sim_animation.curIter();
+    requestRedraw(true);
 }
 
 void ThreeBodyProblem_Scene::setCurrentSimFromResult(int index)
 {
-    if (index < 0 || index >= (int)results.size())
+    if (index < 0 || index >= (int)orbit_library.size())
         return;
 
-    setCurrentSim(results[index]);
+    // recorded under another G/dt, replaying it under env would be a different orbit
+    Sim sim;
+    if (!OrbitLibrary::restore(env, orbit_library[index], sim))
+        return;
+
+    setCurrentSim(sim);
+}
+
+void ThreeBodyProblem_Scene::harvestResult(const ScanService::PixelResult& r)
+{
+    // periodic policies report STABLE, survival policies: lasted the whole run
+    const bool stable = (r.best.type == StopResult::STABLE) ||
+        (StopPolicy<flt>::ranks_by_survival && r.best_iter >= iter_lim);
+
+    if (stable && (int)harvest_queue.size() < max_harvest_queue)
+        harvest_queue.push_back(r);
+}
+
+void ThreeBodyProblem_Scene::processHarvest()
+{
+    // finished batch: insert on the scene thread (the library isn't shared)
+    if (harvest_task.valid() &&
+        harvest_task.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        harvest_task.get();
+
+        bool changed = false;
+        for (size_t i = 0; i < harvest_batch->forms.size(); i++)
+        {
+            bool inserted = false;
+            if (orbit_library.insert(harvest_batch->forms[i], harvest_batch->records[i], &inserted) < 0)
+                continue;
+
+            if (inserted)
+                changed = true;
+            else
+                harvest_duplicates++;
+        }
+        harvest_batch.reset();
+
+        if (changed)
+            refreshResults();
+    }
+
+    if (!harvest_task.valid() && !harvest_queue.empty())
+    {
+        auto batch = std::make_shared<HarvestBatch>(env, orbit_library.config);
+        const size_t n = std::min(harvest_queue.size(), (size_t)harvest_batch_size);
+        batch->items.assign(harvest_queue.end() - n, harvest_queue.end());
+        harvest_queue.resize(harvest_queue.size() - n);
+
+        // the task only touches the batch, so it may outlive the scene
+        harvest_batch = batch;
+        harvest_task = submitSimTask([batch]()
+        {
+            OrbitLibrary canon; // canonicalise() only reads config
+            canon.config = batch->config;
+
+            for (const ScanService::PixelResult& r : batch->items)
+            {
+                Sim sim;
+                SimGrid::setupSim(batch->env, r.pos, r.best_sim, sim);
+
+                OrbitLibrary::CanonicalForm form;
+                if (!canon.canonicalise(batch->env, sim, form))
+                    continue;
+
+                batch->forms.push_back(std::move(form));
+                batch->records.push_back(OrbitLibrary::makeRecord(batch->env, sim));
+            }
+        });
+    }
+
+    harvest_pending = (int)harvest_queue.size() + (harvest_batch ? (int)harvest_batch->items.size() : 0);
+}
+
+void ThreeBodyProblem_Scene::refreshResults()
+{
+    results_str.clear();
+    results_cstr.clear();
+
+    char name[96];
+    for (size_t i = 0; i < orbit_library.size(); i++)
+    {
+        const OrbitRecord& rec = orbit_library[i];
+        snprintf(name, sizeof(name), "E=%.4f  T=%.3f  (x%u)", rec.energy, rec.period, rec.hits);
+        results_str.push_back(name);
+    }
+
+    // pointers taken after all strings are in place (push_back may reallocate)
+    for (const std::string& str : results_str)
+        results_cstr.push_back(str.c_str());
+
+    library_size = (int)orbit_library.size();
 }
 
 void ThreeBodyProblem_Scene::launchPreset(vec2 c, vec2 vel_a, vec2 vel_b, vec2 vel_c, double path_alpha, int fade_step)
@@ -158,14 +783,457 @@ void ThreeBodyProblem_Scene::launchPreset(vec2 c, vec2 vel_a, vec2 vel_b, vec2 v
     startAnimation(path_alpha, fade_step);
 }
 
+bool ThreeBodyProblem_Scene::bestSimAt(vec2 pos, Sim& out, bool fresh)
+{
+    if (!hover_context)
+        hover_context = HoverContext::create(env);
+    else
+        hover_context->bind(env);
+
+    SimGrid& grid = hover_context->grid;
+    hit_from_index = false;
+
+    // the index only answers for the env it was scanned with (e.g. not after a max_vel change)
+    if (!fresh && result_index.envKey() == ScanService::envKey(env))
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        const ResultIndex::Entry* hit = result_index.find(pos);
+        last_lookup_us = std::chrono::duration<f64, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+        if (hit)
+        {
+            // a scanned pixel covers pos, replay its best configuration
+            index_hits++;
+            if (hit->best.excluded())
+                return false;
+
+            hit_entry = *hit;
+            hit_from_index = true;
+            grid.start_pos = hit->pos;
+            grid.setupSim(hit->best_sim, out);
+            return true;
+        }
+        index_misses++;
+    }
+
+    grid.setup(pos);
+    grid.run();
+
+    if (grid.bestStability().excluded())
+        return false;
+
+    out = grid.bestSimConfig();
+    return true;
+}
+
+void ThreeBodyProblem_Scene::hoverAt(vec2 pos)
+{
+    Sim sim;
+    if (!bestSimAt(pos, sim, !hover_use_index))
+        return;
+
+    // still over the scanned pixel that's already plotted (same env), nothing changes
+    const u64 env_key = ScanService::envKey(env);
+    if (hit_from_index && plotted_from_index &&
+        hit_entry.pos == plotted_entry.pos &&
+        hit_entry.best_sim == plotted_entry.best_sim &&
+        env_key == plotted_env_key)
+        return;
+
+    setCurrentSim(sim);
+    plotted_from_index = hit_from_index;
+    plotted_entry = hit_entry;
+    plotted_env_key = env_key;
+}
+
 void ThreeBodyProblem_Scene::beginScan()
 {
-    results.clear();
-    results_str.clear();
-    results_cstr.clear();
+    // the library persists across scans, only pending harvests are dropped
+    harvest_queue.clear();
+
+    ScanService::shared().cancel(scan_client);
+    scan_res = scan_res_setting;
+    env.prefilter_unbound = prefilter_unbound;
+    env.prefilter_hierarchical = prefilter_hierarchical;
+    scan_submit_pending = true;
+    scan_expected = 0;
+    scan_received = 0;
     scanning = true;
 }
 
+void ThreeBodyProblem_Scene::submitScan(int stage_w, int stage_h)
+{
+    ScanService& service = ScanService::shared();
+
+    // one tile per raster row, sampled at pixel centers
+    std::vector<ScanService::PixelRequest> tile;
+    tile.reserve(scan_res);
+
+    {
+        const vec2 p0 = camera.getTransform().toWorld<flt>(0, 0);
+        const vec2 px = camera.getTransform().toWorld<flt>((flt)stage_w / (flt)scan_res, 0);
+        const vec2 py = camera.getTransform().toWorld<flt>(0, (flt)stage_h / (flt)scan_res);
+        const flt dx = std::max(std::abs(px.x - p0.x), std::abs(py.x - p0.x));
+        const flt dy = std::max(std::abs(px.y - p0.y), std::abs(py.y - p0.y));
+        scan_pixel_radius = std::max(dx, dy) * flt(0.5);
+    }
+    result_index.setEnvKey(ScanService::envKey(env));
+
+    for (int py = 0; py < scan_res; py++)
+    {
+        tile.clear();
+        for (int px = 0; px < scan_res; px++)
+        {
+            flt sx = ((flt)px + flt(0.5)) * (flt)stage_w / (flt)scan_res;
+            flt sy = ((flt)py + flt(0.5)) * (flt)stage_h / (flt)scan_res;
+            tile.push_back({ px, py, camera.getTransform().toWorld<flt>(sx, sy) });
+        }
+        service.submit(scan_client, env, tile);
+    }
+
+    scan_expected = scan_res * scan_res;
+}
+
+void ThreeBodyProblem_Scene::startSweep()
+{
+    // sweep the region currently in view, with the scene's settings for
+    // everything that isn't swept (and the Screener choices, as a scan would)
+    ParamSweep::Config cfg = sweep_config;
+    cfg.base = env;
+    cfg.base.prefilter_unbound = prefilter_unbound;
+    cfg.base.prefilter_hierarchical = prefilter_hierarchical;
+    cfg.x0 = view_lo.x; cfg.y0 = view_lo.y;
+    cfg.x1 = view_hi.x; cfg.y1 = view_hi.y;
+    sweep.start(cfg);
+}
+
+void ThreeBodyProblem_Scene::startMonteCarlo()
+{
+    // sample the region currently in view, over the velocity span of a scan grid
+    MonteCarlo::Config cfg = mc_config;
+    cfg.x0 = view_lo.x; cfg.y0 = view_lo.y;
+    cfg.x1 = view_hi.x; cfg.y1 = view_hi.y;
+    cfg.vel_range = env.max_vel * flt(vel_grid_size - 1) / flt(2);
+    cfg.max_in_flight = std::max(1, (int)std::thread::hardware_concurrency());
+
+    mc_estimate = MonteCarlo::Estimate();
+    mc_histogram.clear();
+    monte_carlo.start(env, cfg);
+}
+
+void ThreeBodyProblem_Scene::verifyCurrentSim()
+{
+    if (precision_task.valid())
+        return;
+
+    // the double-double rerun costs many times the f64 one, keep it off the scene thread
+    auto result = std::make_shared<PrecisionReport>();
+    precision_result = result;
+    precision_task = submitSimTask([result, env = current_env, sim = current_sim]()
+    {
+        *result = checkPrecision(env, sim);
+    });
+    precision_running = true;
+}
+
+void ThreeBodyProblem_Scene::pollPrecision()
+{
+    if (!precision_task.valid() ||
+        precision_task.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    precision_task.get();
+    precision_report = *precision_result;
+    precision_result.reset();
+    has_precision_report = true;
+    precision_running = false;
+}
+
+void ThreeBodyProblem_Scene::verifyCurrentSimParareal()
+{
+    if (parareal_task.valid())
+        return;
+
+    // the coarse passes are serial (and so is the comparison run), keep it off the scene thread.
+    // Own thread rather than the pool: verifyParareal() waits on pool tasks itself
+    auto result = std::make_shared<PararealReport>();
+    parareal_result = result;
+    parareal_task = std::async(std::launch::async, [result, env = current_env, sim = current_sim, cfg = parareal_config]()
+    {
+        *result = verifyParareal(env, sim, cfg);
+    });
+    parareal_running = true;
+}
+
+void ThreeBodyProblem_Scene::pollParareal()
+{
+    if (!parareal_task.valid() ||
+        parareal_task.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    parareal_task.get();
+    parareal_report = *parareal_result;
+    parareal_result.reset();
+    has_parareal_report = true;
+    parareal_running = false;
+}
+
+void ThreeBodyProblem_Scene::continueCurrentOrbit()
+{
+    if (continuation_task.valid())
+        return;
+
+    // the period search alone can run to max_iter, then every step integrates
+    // a shooting Jacobian. Own thread rather than the pool: the Jacobian waits on pool tasks
+    auto job = std::make_shared<ContinuationJob>();
+    job->restarted = true;
+    continuation_job = job;
+    continuation_task = std::async(std::launch::async, [job, env = current_env, sim = current_sim,
+        cfg = continuation_config, steps = continuation_steps]()
+    {
+        job->ok = job->continuation.start(env, sim, cfg);
+        if (job->ok)
+            job->continuation.run(steps);
+    });
+    continuation_running = true;
+}
+
+void ThreeBodyProblem_Scene::extendBranch()
+{
+    if (continuation_task.valid())
+        return;
+
+    // continues from the last point with the step size reached so far
+    auto job = std::make_shared<ContinuationJob>();
+    job->continuation = continuation;
+    continuation_job = job;
+    continuation_task = std::async(std::launch::async, [job, steps = continuation_steps]()
+    {
+        job->continuation.run(steps);
+    });
+    continuation_running = true;
+}
+
+void ThreeBodyProblem_Scene::pollContinuation()
+{
+    if (!continuation_task.valid() ||
+        continuation_task.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    continuation_task.get();
+    continuation = std::move(continuation_job->continuation);
+    if (continuation_job->restarted)
+    {
+        continuation_failed = !continuation_job->ok;
+        branch_selected = 0;
+    }
+    continuation_job.reset();
+
+    branch_points = continuation.branch();
+    continuation_running = false;
+}
+
+void ThreeBodyProblem_Scene::showBranchPoint(int i)
+{
+    if (branch_points.empty())
+        return;
+
+    // G / softening points are animated under the point's parameter, the
+    // scene env (scans, hover) keeps its own
+    SimEnv point_env = env;
+    Sim sim;
+    continuation.restore(i, point_env, sim);
+    setCurrentSim(sim, point_env);
+    startAnimation();
+}
+
+template<int N, template<class> class Policy>
+void ThreeBodyProblem_Scene::plotNBody(const SimEnv& nbody_env, std::span<const vec2> pos, std::span<const vec2> vel, std::span<const flt> mass)
+{
+    // the task owns copies of everything it reads, so it may outlive the scene
+    auto run = std::make_shared<NBodyRun>();
+    nbody_run = run;
+    nbody_running = true;
+    nbody_task = submitSimTask([run, nbody_env,
+        pos = std::vector<vec2>(pos.begin(), pos.end()),
+        vel = std::vector<vec2>(vel.begin(), vel.end()),
+        mass = std::vector<flt>(mass.begin(), mass.end()),
+        force = (NBodyForce)nbody_force, theta = nbody_theta]()
+    {
+        using NSim = NBodySim<flt, N, Policy>;
+
+        // large N: keep the sims off the stack
+        auto start = std::make_unique<NSim>();
+        auto end = std::make_unique<NSim>();
+        start->setForce(force);
+        start->setTheta(theta);
+        start->setup(nbody_env, pos, vel, mass);
+
+        // keyframes only to recover the final state for the drift report
+        SimKeyframes<NSim> keyframes;
+        keyframes.setInterval(1000);
+
+        run->plot.setFullPathAlpha(0.2);
+        run->plot.setFadeStepIters(10);
+
+        const auto t0 = std::chrono::steady_clock::now();
+        run->plot.plot(nbody_env, *start, &keyframes);
+        keyframes.seek(nbody_env, keyframes.lastIter(), *end);
+        run->ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        const flt e0 = start->energy();
+        run->drift = (f64)(std::abs(end->energy() - e0) / std::max(std::abs(e0), std::numeric_limits<flt>::min()));
+        run->bodies = N;
+        run->iters = end->curIter();
+        run->used = start->activeForce();
+        run->result = end->stability();
+    });
+}
+
+void ThreeBodyProblem_Scene::pollNBody()
+{
+    if (!nbody_task.valid() ||
+        nbody_task.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    nbody_task.get();
+    endAnimation();
+
+    NBodyRun& run = *nbody_run;
+    nbody_plot = std::move(run.plot);
+    nbody_bodies = run.bodies;
+    nbody_iters = run.iters;
+    nbody_used = run.used;
+    nbody_result = run.result;
+    nbody_drift = run.drift;
+    nbody_ms = run.ms;
+    nbody_run.reset();
+
+    nbody_running = false;
+    nbody_active = true;
+}
+
+void ThreeBodyProblem_Scene::launchNBodyPreset(int preset)
+{
+    if (nbody_task.valid())
+        return;
+
+    // presets stop on escape (StopPolicy_MaxDist) whatever the scene's policy,
+    // the three-body policies don't take N bodies
+    SimEnv nbody_env = env;
+    const flt sqrt3_2 = std::sqrt((flt)3) / 2;
+
+    switch (preset)
+    {
+    case 0:
+    {
+        // Burrau's problem: masses 3, 4, 5 at rest on a 3-4-5 triangle, ends in
+        // an ejection (lightly softened, fixed steps can't resolve the closest encounters)
+        nbody_env.dt = (flt)0.0002;
+        nbody_env.soft2 = (flt)0.001;
+        nbody_env.max_iter = 350000;
+
+        const vec2 pos[] = { vec2(1, 3), vec2(-2, -1), vec2(1, -1) };
+        const vec2 vel[3] = {};
+        const flt mass[] = { 3, 4, 5 };
+        plotNBody<3, StopPolicy_MaxDist>(nbody_env, pos, vel, mass);
+        break;
+    }
+    case 1:
+    {
+        // two circular binaries on a wide circular orbit about each other
+        nbody_env.dt = (flt)0.005;
+        nbody_env.max_iter = 40000;
+
+        const flt m = (flt)0.5, d = (flt)0.3, D = 3;
+        const flt v_in = std::sqrt(m / (2 * d));
+        const flt v_out = std::sqrt(2 * m / (2 * D));
+
+        const vec2 pos[] = {
+            vec2(-D / 2 - d / 2, 0), vec2(-D / 2 + d / 2, 0),
+            vec2( D / 2 - d / 2, 0), vec2( D / 2 + d / 2, 0)
+        };
+        const vec2 vel[] = {
+            vec2(0, -v_in - v_out), vec2(0, v_in - v_out),
+            vec2(0, -v_in + v_out), vec2(0, v_in + v_out)
+        };
+        const flt mass[] = { m, m, m, m };
+        plotNBody<4, StopPolicy_MaxDist>(nbody_env, pos, vel, mass);
+        break;
+    }
+    case 2:
+    {
+        // restricted problem: Sun and Jupiter (mu = 0.001) on a circular orbit,
+        // massless test particles at L4, L5 and displaced from L4 (tadpole orbit)
+        nbody_env.dt = (flt)0.01;
+        nbody_env.max_iter = 30000;
+
+        const flt mu = (flt)0.001;
+        const vec2 pos[] = {
+            vec2(-mu, 0), vec2(1 - mu, 0),
+            vec2((flt)0.5 - mu, sqrt3_2), vec2((flt)0.5 - mu, -sqrt3_2),
+            vec2(((flt)0.5 - mu) * (flt)1.02, sqrt3_2 * (flt)1.02)
+        };
+
+        // co-rotating at unit angular velocity
+        vec2 vel[5];
+        for (int i = 0; i < 5; i++)
+            vel[i] = vec2(-pos[i].y, pos[i].x);
+
+        const flt mass[] = { 1 - mu, mu, 0, 0, 0 };
+        plotNBody<5, StopPolicy_MaxDist>(nbody_env, pos, vel, mass);
+        break;
+    }
+    case 3:
+    {
+        // uniform disc of total mass 1 in (approximate) rotational balance,
+        // escapers are expected so only the iteration limit stops it
+        constexpr int N = 1024;
+        nbody_env.dt = (flt)0.02;
+        nbody_env.soft2 = (flt)0.01;
+        nbody_env.max_iter = 500;
+
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<flt> uniform(0, 1);
+
+        const flt R = 2;
+        std::vector<vec2> pos(N), vel(N);
+        std::vector<flt> mass(N, (flt)1 / N);
+        for (int i = 0; i < N; i++)
+        {
+            const flt r = R * std::sqrt(uniform(rng));
+            const flt a = 2 * std::numbers::pi_v<flt> * uniform(rng);
+            const flt v = std::sqrt(r) / R; // sqrt(M(<r) / r) with M(<r) = r^2 / R^2
+            pos[i] = vec2(r * std::cos(a), r * std::sin(a));
+            vel[i] = vec2(-std::sin(a) * v, std::cos(a) * v);
+        }
+        plotNBody<N, StopPolicy_None>(nbody_env, pos, vel, mass);
+        break;
+    }
+    }
+}
+
+Color ThreeBodyProblem_Scene::scanColor(StopResult best, int best_iter) const
+{
+    // every configuration ruled out before integration (E >= 0). Final, the
+    // pixel is never integrated
+    if (best.type == StopResult::RULED_OUT)
+        return Color(24, 24, 32);
+
+    // every integrated configuration diverged (energy / angular momentum drift),
+    // kept apart from the red of an immediate escape
+    if (best.type == StopResult::DIVERGED)
+        return Color(96, 96, 96);
+
+    Color col = Color::red;
+
+    float ratio = ((float)best_iter / (float)iter_lim);
+    ratio = std::sqrt(ratio);
+    col.adjustHue(ratio * 360.0f);
+
+    return col;
+}
+
 void ThreeBodyProblem_Scene::viewportProcess(
     [[maybe_unused]] Viewport* ctx,
     [[maybe_unused]] double dt)
@@ -177,60 +1245,60 @@ void ThreeBodyProblem_Scene::viewportProcess(
     int ih = (int)ctx->height();
 
     //bmp.setRasterSize(iw, ih);
-    bmp.setRasterSize(256, 256);
+    bmp.setRasterSize(scan_res, scan_res);
     bmp.setStageRect(0, 0, iw, ih);
 
-    if (scanning)
+    ScanService& service = ScanService::shared();
+
+    // let the service favour tiles that are on screen in this viewport
     {
-        bool complete = bmp.forEachWorldPixel(current_row, [&](int px, int py, flt wx, flt wy)
+        const vec2 corners[4] = {
+            camera.getTransform().toWorld<flt>(0, 0),
+            camera.getTransform().toWorld<flt>(iw, 0),
+            camera.getTransform().toWorld<flt>(0, ih),
+            camera.getTransform().toWorld<flt>(iw, ih)
+        };
+
+        vec2 lo = corners[0], hi = corners[0];
+        for (const vec2& p : corners)
         {
-            //if (wy > 0.00000001) return;
-
-            SimGrid sims(env);
-            sims.setup({ wx, wy });
-            sims.run();
-
-            //int stability = sims.bestStability();
-            Color col;
+            lo.x = std::min(lo.x, p.x); lo.y = std::min(lo.y, p.y);
+            hi.x = std::max(hi.x, p.x); hi.y = std::max(hi.y, p.y);
+        }
+        service.setVisibleRect(scan_client, lo.x, lo.y, hi.x, hi.y);
+        view_lo = lo;
+        view_hi = hi;
+    }
 
-            //if (stability >= UNDETERMINED)
-            //{
-                Sim& best = sims.sims[sims.best_sim];
-                col = Color::red;
-
-                float ratio = ((float)best.curIter() / (float)iter_lim);
-                ratio = std::sqrt(ratio);
-                col.adjustHue(ratio * 360.0f);
-
-                //if (stability == STABLE)
-                //{
-                //    col = Color(0, 255, 0, 255);
-                //    results.push_back(sims.bestSimConfig());
-                //
-                //    std::string name = "(" + std::to_string(wx) + std::to_string(wy) + ")";
-                //    results_str.push_back(name);
-                //    results_cstr.push_back(results_str.back().c_str());
-                //
-                //}
-                //else
-                //    col = Color(255, 0, 0, 80);
-
-                
-            //}
-            //else
-            //    col = Color(0, 0, 255, 40);
+    if (scanning)
+    {
+        if (scan_submit_pending)
+        {
+            submitScan(iw, ih);
+            scan_submit_pending = false;
+        }
 
-            bmp.setPixel(px, py, col);
+        scan_results.clear();
+        service.collect(scan_client, scan_results);
 
-        }, 4, 512);
+        for (const ScanService::PixelResult& r : scan_results)
+        {
+            bmp.setPixel(r.px, r.py, scanColor(r.best, r.best_iter));
+            result_index.insert({ r.pos, scan_pixel_radius, r.best, r.best_sim, r.best_iter });
+            harvestResult(r);
+        }
+        index_size = (int)result_index.size();
 
-        if (complete)
+        scan_received += (int)scan_results.size();
+        if (scan_received >= scan_expected)
         {
             scanning = false;
         }
+    }
 
+    // only frames that changed scan tiles need a redraw
+    if (bmp.takeDirty())
         requestRedraw(true);
-    }
 }
 
 void ThreeBodyProblem_Scene::viewportDraw(Viewport* ctx) const
@@ -238,7 +1306,7 @@ void ThreeBodyProblem_Scene::viewportDraw(Viewport* ctx) const
     /// draw scene on this viewport (no modifying sim state)
     ctx->transform(camera.getTransform());
 
-    ctx->drawImage(bmp);
+    bmp.draw(ctx);
     ctx->drawWorldAxis(0.1, 0.00, 0.3);
 
     if (interactive_enabled)
@@ -246,7 +1314,10 @@ void ThreeBodyProblem_Scene::viewportDraw(Viewport* ctx) const
         ctx->worldHudMode();
         ctx->setLineCap(LineCap::CAP_ROUND);
 
-        current_plot.draw(ctx, playingAnimation() ? sim_animation.curIter() : -1, particle_r, particle_r*3);
+        if (nbody_active)
+            nbody_plot.draw(ctx, -1, particle_r, particle_r*3);
+        else
+            current_plot.draw(ctx, playingAnimation() ? sim_animation.curIter() : -1, particle_r, particle_r*3);
 
 
         //if (playingAnimation())
@@ -271,7 +1342,7 @@ void ThreeBodyProblem_Scene::viewportDraw(Viewport* ctx) const
                 drawParticle(sim_animation.particleB(), Color::green, 0.5, particle_r, glow_r);
                 drawParticle(sim_animation.particleC(), Color::yellow, 0.5, particle_r, glow_r);
             }
-            else
+            else if (!nbody_active)
             {
                 drawParticle(vec2{ -1,0 }, Color::red, 0.5, particle_r, glow_r);
                 drawParticle(vec2{ 1,0 }, Color::green, 0.5, particle_r, glow_r);
@@ -314,16 +1385,12 @@ void ThreeBodyProblem_Scene::onPointerDown(PointerEvent e)
         // on click, lock body C to mouse world-pos
         vec2 pos = camera.getTransform().toWorld<flt>(e.x(), e.y());
 
-        SimGrid sims(env);
-        sims.setup(pos);
-        sims.run();
-
         requestRedraw(true);
 
-        //if (sims.bestStability() >= UNDETERMINED)
-        if (sims.bestStability().type != StopResult::INVALID)
+        Sim sim;
+        if (bestSimAt(pos, sim, !hover_use_index))
         {
-            setCurrentSim(sims.bestSimConfig());
+            setCurrentSim(sim);
             startAnimation();
         }
     }
@@ -340,6 +1407,9 @@ void ThreeBodyProblem_Scene::onPointerMove(PointerEvent e)
     if (!e.hoveredOver(this))
         return;
 
+    // the hovered viewport gets first pick of the shared scan workers
+    ScanService::shared().setFocus(scan_client);
+
     if (!interactive_enabled) return;
 
     requestRedraw(true);
@@ -347,15 +1417,7 @@ void ThreeBodyProblem_Scene::onPointerMove(PointerEvent e)
     if (!playingAnimation())
     {
         input_pos = camera.getTransform().toWorld<flt>(e.x(), e.y());
-
-        SimGrid sims(env);
-        sims.setup(input_pos);
-        sims.run();
-
-        if (sims.bestStability().type != StopResult::INVALID)
-        {
-            setCurrentSim(sims.bestSimConfig());
-        }
+        hoverAt(input_pos);
     }
 }
 
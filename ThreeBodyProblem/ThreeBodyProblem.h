@@ -1,5 +1,16 @@
 #pragma once
-#include "orbit_sim.h"
+#include "core/orbit_sim.h"
+#include "sim_plot.h"
+#include "scan_service.h"
+#include "param_sweep.h"
+#include "orbit_library.h"
+#include "precision_check.h"
+#include "core/monte_carlo.h"
+#include "core/parareal.h"
+#include "core/continuation.h"
+#include "core/nbody_sim.h"
+#include "result_index.h"
+#include "tiled_image.h"
 
 SIM_BEG;
 
@@ -21,11 +32,14 @@ struct ThreeBodyProblem_Scene : public Scene<ThreeBodyProblem_Scene>
     //template<class T> using StopPolicy  = StopPolicy_Periodic<T>;
 
     static constexpr int vel_grid_size  = 4;
+    int scan_res                        = 256; // raster of the current scan
+    int scan_res_setting                = 256; // applied on the next scan
     int iter_lim                        = 200000;
     flt G                               = 1.0f;
     flt max_vel                         = 1.0f;//1.0f;
     flt dt = 0.02f;
     int animation_speed                 = 5;
+    int keyframe_interval               = 500;
 
     static constexpr f64 particle_r = 2.0;
     static constexpr f64 glow_r = 24.0;
@@ -35,6 +49,14 @@ struct ThreeBodyProblem_Scene : public Scene<ThreeBodyProblem_Scene>
     using SimPlot = SimPlot<flt>;
     using Sim     = Sim<flt, StopPolicy>;
     using SimGrid = SimGrid<flt, vel_grid_size, StopPolicy>;
+    using SimKeyframes = SimKeyframes<Sim>;
+    using ScanService = ScanService<flt, vel_grid_size, StopPolicy>;
+    using ParamSweep = ParamSweep<flt, vel_grid_size, StopPolicy>;
+    using OrbitLibrary = OrbitLibrary<flt>;
+    using MonteCarlo = MonteCarlo<flt, StopPolicy>;
+    using ResultIndex = ResultIndex<flt>;
+    using OrbitContinuation = OrbitContinuation<flt>;
+    using HoverContext = ScanContext<flt, vel_grid_size, StopPolicy, false>; // no helper tasks: hover doesn't allocate
 
     const vec2 undefined_pos = vec2::highest();
 
@@ -42,13 +64,81 @@ struct ThreeBodyProblem_Scene : public Scene<ThreeBodyProblem_Scene>
    
     CameraInfo             camera;
     CameraNavigator        navigator;
-    WorldImageT<flt>       bmp;
+    TiledWorldImage<flt>   bmp;
 
     bool scanning = false;
-    int current_row = 0;
     bool interactive_enabled = true;
 
-    std::vector<Sim>         results;
+    // scan tiles are computed by the ScanService shared by all scenes
+    int  scan_client = -1;
+    bool scan_submit_pending = false;
+    int  scan_expected = 0;
+    int  scan_received = 0;
+    std::vector<ScanService::PixelResult> scan_results;
+    flt  scan_pixel_radius = 0; // world half-width of a pixel of the current scan
+    bool prefilter_unbound = false;     // applied to env on the next scan
+    bool prefilter_hierarchical = false;
+    bool pin_scan_workers = false;
+
+    // finished scan pixels, hover/click use these before running a fresh SimGrid
+    ResultIndex result_index;
+    bool hover_use_index = true;
+    int  index_hits = 0;
+    int  index_misses = 0;
+    int  index_size = 0;
+    f64  last_lookup_us = 0;
+
+    // scan pixel behind the last bestSimAt() answer / behind current_sim, so hover
+    // doesn't re-plot (up to env.max_iter steps) while it stays on the same pixel
+    ResultIndex::Entry hit_entry{};
+    bool               hit_from_index = false;
+    ResultIndex::Entry plotted_entry{};
+    bool               plotted_from_index = false;
+    u64                plotted_env_key = 0;
+
+    // grid reused by every fresh hover/click sim (created on first use)
+    std::unique_ptr<HoverContext> hover_context;
+
+    // visible world rect (updated each frame)
+    vec2 view_lo{}, view_hi{};
+
+    // parameter sweeps (run in the background on the shared scan workers)
+    ParamSweep         sweep;
+    ParamSweep::Config sweep_config;
+    bool               sweep_running = false;
+    float              sweep_progress = 0.0f;
+
+    // Monte Carlo estimates over the region in view (sampled, stops at the requested precision)
+    MonteCarlo           monte_carlo;
+    MonteCarlo::Config   mc_config;
+    MonteCarlo::Estimate mc_estimate;
+    std::vector<float>   mc_histogram;
+    bool                 mc_running = false;
+
+    // stable scan results are canonicalised into the library (duplicates dropped).
+    // Canonicalising integrates up to env.max_iter steps, so batches taken from
+    // harvest_queue run on a worker and are inserted by the scene once finished
+    struct HarvestBatch
+    {
+        SimEnv env;
+        OrbitLibrary::Config config;
+        std::vector<ScanService::PixelResult> items;
+        std::vector<OrbitLibrary::CanonicalForm> forms; // per canonicalised item
+        std::vector<OrbitRecord> records;
+
+        HarvestBatch(const SimEnv& e, const OrbitLibrary::Config& c) : env(e), config(c) {}
+    };
+
+    OrbitLibrary             orbit_library;
+    std::vector<ScanService::PixelResult> harvest_queue;
+    std::shared_ptr<HarvestBatch> harvest_batch; // in flight (owned by the task too)
+    std::future<void>        harvest_task;
+    static constexpr int     max_harvest_queue = 4096;
+    int                      harvest_batch_size = 8;
+    int                      harvest_pending = 0;
+    int                      harvest_duplicates = 0;
+    int                      library_size = 0;
+
     std::vector<std::string> results_str;
     std::vector<const char*> results_cstr;
     int selected_result = 0;
@@ -60,14 +150,89 @@ struct ThreeBodyProblem_Scene : public Scene<ThreeBodyProblem_Scene>
     vec2     input_pos{};
 
     SimEnv   env = SimEnv(G, max_vel, iter_lim, dt);
-    Sim      current_sim;
-    SimPlot  current_plot;
+    SimEnv   current_env = env; // current_sim's env: env, or a continuation point's G/soft2
+    Sim          current_sim;
+    SimPlot      current_plot;
+    SimKeyframes current_keyframes;
 
     bool     sim_animating = false;
     Sim      sim_animation;
+    int      animation_dir = 1; // 1 = forward, -1 = reverse, 0 = paused
+    int      timeline_len = 0;  // iterations covered by current_keyframes
+
+    // last double-double verification of current_sim, run in the background
+    // (the task owns its result, so it may outlive the scene)
+    PrecisionReport precision_report;
+    bool            has_precision_report = false;
+    bool            precision_running = false;
+    std::shared_ptr<PrecisionReport> precision_result;
+    std::future<void> precision_task;
+
+    // last parallel-in-time verification of current_sim, run in the background
+    // (the task owns its result, so it may outlive the scene)
+    PararealConfig  parareal_config;
+    PararealReport  parareal_report;
+    bool            has_parareal_report = false;
+    bool            parareal_running = false;
+    std::shared_ptr<PararealReport> parareal_result;
+    std::future<void> parareal_task;
+
+    // periodic-orbit family followed from current_sim across a parameter. Steps
+    // run on their own thread on a copy (the Jacobian columns wait on pool
+    // tasks, as in Parareal), the scene takes it over once finished
+    struct ContinuationJob
+    {
+        OrbitContinuation continuation;
+        bool ok = true;
+        bool restarted = false; // new branch rather than an extension
+    };
+
+    OrbitContinuation          continuation;
+    OrbitContinuation::Config  continuation_config;
+    std::vector<BranchPoint>   branch_points;  // copy of continuation.branch() for the UI
+    int                        continuation_steps = 20;
+    int                        branch_selected = 0;
+    bool                       continuation_failed = false;
+    bool                       continuation_running = false;
+    std::shared_ptr<ContinuationJob> continuation_job; // in flight (owned by the task too)
+    std::future<void>          continuation_task;
+
+    // general N-body presets (arbitrary masses), plotted instead of current_sim.
+    // Integrated on a worker (the 1024-body disc takes seconds), the scene
+    // takes over the finished NBodyRun
+    struct NBodyRun
+    {
+        SimPlot    plot;
+        int        bodies = 0;
+        int        iters = 0;
+        NBodyForce used = NBodyForce::AUTO;
+        StopResult result;
+        f64        drift = 0;
+        f64        ms = 0;
+    };
+
+    int        nbody_preset = 0;
+    int        nbody_force = (int)NBodyForce::AUTO;
+    flt        nbody_theta = 0.5;
+    SimPlot    nbody_plot;
+    bool       nbody_active = false;
+    bool       nbody_running = false;
+    std::shared_ptr<NBodyRun> nbody_run; // in flight (owned by the task too)
+    std::future<void>         nbody_task;
+    int        nbody_bodies = 0;
+    int        nbody_iters = 0;         // iterations plotted
+    NBodyForce nbody_used = NBodyForce::AUTO;
+    StopResult nbody_result;
+    f64        nbody_drift = 0;         // relative energy drift over the plot
+    f64        nbody_ms = 0;
 
     // stats for UI
     int cur_iter = 0;
+    KernelStats kernel_stats;
+    ScanService::Stats scan_stats;
+
+    // kernel ISA override (KernelISA::AUTO = best supported)
+    int kernel_isa = (int)KernelISA::AUTO;
 
     /// ─────── methods ───────
     bool playingAnimation() const { return sim_animating; }
@@ -77,13 +242,20 @@ struct ThreeBodyProblem_Scene : public Scene<ThreeBodyProblem_Scene>
 
     //bool hasChosenSim() const { return chosen_point != undefined_pos; }
     
-    void setCurrentSim(Sim sim) { 
+    void setCurrentSim(Sim sim) { setCurrentSim(sim, env); }
+    void setCurrentSim(Sim sim, const SimEnv& sim_env) { 
         current_sim = sim; 
-        current_sim.plot(env, current_plot);
+        current_env = sim_env;
+        nbody_active = false;
+        plotted_from_index = false;
+        current_keyframes.setInterval(keyframe_interval);
+        current_plot.plot(current_env, current_sim, &current_keyframes);
+        timeline_len = current_keyframes.lastIter();
     }
     void startAnimation(double full_path_alpha=0.15, int fade_step=10) {
         sim_animation = current_sim; 
         sim_animating = true; 
+        animation_dir = 1;
         current_plot.setFullPathAlpha(full_path_alpha);
         current_plot.setFadeStepIters(fade_step);
     }
@@ -93,9 +265,33 @@ struct ThreeBodyProblem_Scene : public Scene<ThreeBodyProblem_Scene>
         current_plot.setFadeStepIters(10);
     }
 
+    void seekAnimation(int iter);
+    void stepAnimation();
+
     void setCurrentSimFromResult(int index);
+    void harvestResult(const ScanService::PixelResult& r);
+    void processHarvest();
+    void refreshResults();
     void launchPreset(vec2 c, vec2 vel_a, vec2 vel_b, vec2 vel_c, double path_alpha = 0.08, int fade_step=10);
+    bool bestSimAt(vec2 pos, Sim& out, bool fresh = false);
+    void hoverAt(vec2 pos);
     void beginScan();
+    void submitScan(int stage_w, int stage_h);
+    void startSweep();
+    void startMonteCarlo();
+    void verifyCurrentSim();
+    void pollPrecision();
+    void verifyCurrentSimParareal();
+    void pollParareal();
+    void continueCurrentOrbit();
+    void extendBranch();
+    void pollContinuation();
+    void showBranchPoint(int i);
+    void launchNBodyPreset(int preset);
+    void pollNBody();
+    template<int N, template<class> class Policy>
+    void plotNBody(const SimEnv& nbody_env, std::span<const vec2> pos, std::span<const vec2> vel, std::span<const flt> mass);
+    Color scanColor(StopResult best, int best_iter) const;
 
     /// ─────── launch config (overridable by Project) ───────
     struct Config {};
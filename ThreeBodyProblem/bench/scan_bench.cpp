@@ -0,0 +1,119 @@
+// Headless screener benchmark (no window / UI), built with -DTHREEBODY_BENCH=ON.
+//
+//   native:  ./ThreeBodyBench [resolution] [iter_lim]
+//   wasm:    node ThreeBodyBench.js [resolution] [iter_lim]
+//
+// Prints one JSON line so native and web throughput can be tracked side by side.
+
+#include "../scan_service.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace bl;
+
+SIM_BEG;
+
+using flt = f64;
+static constexpr int vel_grid_size = 4;
+
+template<class T> using StopPolicy = StopPolicy_MaxDist<T>;
+using BenchGrid = SimGrid<flt, vel_grid_size, StopPolicy, false>;
+using BenchService = ScanService<flt, vel_grid_size, StopPolicy>;
+
+static f64 secondsSince(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<f64>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static u64 totalLaneSteps()
+{
+    const KernelStats stats = KernelStats::snapshot();
+    u64 steps = 0;
+    for (int i = 0; i < (int)KernelISA::COUNT; i++)
+        steps += stats.steps[i];
+    return steps;
+}
+
+// C linkage: reachable from main() without naming the project namespace
+extern "C" int threebody_bench_main(int argc, char** argv)
+{
+    const int res = (argc > 1) ? std::max(1, std::atoi(argv[1])) : 64;
+    const int iter_lim = (argc > 2) ? std::max(1, std::atoi(argv[2])) : 20000;
+
+    const SimEnv<flt> env(flt(1), flt(1), iter_lim, flt(0.02));
+    auto pixelPos = [res](int px, int py)
+    {
+        return Vec2<flt>(
+            flt(-2.5) + flt(5) * (flt(px) + flt(0.5)) / flt(res),
+            flt(-2.5) + flt(5) * (flt(py) + flt(0.5)) / flt(res));
+    };
+
+    // 1) single-thread kernel throughput (one row of pixels)
+    f64 kernel_steps_per_s = 0;
+    {
+        static BenchGrid grid(env);
+        const u64 steps0 = totalLaneSteps();
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int px = 0; px < res; px++)
+        {
+            grid.setup(pixelPos(px, res / 2));
+            grid.run();
+        }
+        kernel_steps_per_s = (f64)(totalLaneSteps() - steps0) / secondsSince(t0);
+    }
+
+    // 2) full scan across every ScanService worker
+    BenchService& service = BenchService::shared();
+    const int client = service.registerClient();
+
+    std::vector<BenchService::PixelRequest> tile;
+    std::vector<BenchService::PixelResult> results;
+    tile.reserve(res);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int py = 0; py < res; py++)
+    {
+        tile.clear();
+        for (int px = 0; px < res; px++)
+            tile.push_back({ px, py, pixelPos(px, py) });
+        service.submit(client, env, tile);
+    }
+
+    size_t received = 0;
+    u64 checksum = 0;
+    while (received < (size_t)res * res)
+    {
+        results.clear();
+        received += service.collect(client, results);
+        for (const BenchService::PixelResult& r : results)
+            checksum += (u64)r.best_iter;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const f64 scan_s = secondsSince(t0);
+    const BenchService::Stats stats = service.stats();
+    service.unregisterClient(client);
+
+    #ifdef __EMSCRIPTEN__
+    const char* platform = "wasm32";
+    #else
+    const char* platform = "native";
+    #endif
+
+    printf("{\"platform\":\"%s\",\"isa\":\"%s\",\"workers\":%d,\"resolution\":%d,\"iter_lim\":%d,"
+           "\"kernel_lane_steps_per_s\":%.0f,\"scan_s\":%.3f,\"scan_px_per_s\":%.1f,\"checksum\":%llu}\n",
+        platform, kernelISAName(activeKernelISA()), stats.workers, res, iter_lim,
+        kernel_steps_per_s, scan_s, (f64)(res * res) / scan_s, (unsigned long long)checksum);
+
+    return 0;
+}
+
+SIM_END;
+
+extern "C" int threebody_bench_main(int argc, char** argv);
+
+int main(int argc, char** argv)
+{
+    return threebody_bench_main(argc, argv);
+}
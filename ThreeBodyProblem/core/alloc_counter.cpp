@@ -0,0 +1,113 @@
+#include "alloc_counter.h"
+
+#if SIM_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+SIM_BEG;
+
+// the global operators below can't name SIM_BEG's namespace, so the
+// recorder is exported with C linkage
+extern "C" void threebody_record_allocation(size_t n)
+{
+    AllocCounter::record(n);
+}
+
+SIM_END;
+
+extern "C" void threebody_record_allocation(size_t n);
+
+namespace
+{
+    void* countedAlloc(std::size_t n)
+    {
+        threebody_record_allocation(n);
+        if (n == 0) n = 1;
+        while (true)
+        {
+            if (void* p = std::malloc(n))
+                return p;
+
+            std::new_handler handler = std::get_new_handler();
+            if (!handler)
+                throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void* countedAlignedAlloc(std::size_t n, std::align_val_t al)
+    {
+        threebody_record_allocation(n);
+        const std::size_t align = (std::size_t)al;
+        const std::size_t size = ((n ? n : 1) + align - 1) / align * align;
+        while (true)
+        {
+            #if defined(_MSC_VER)
+            void* p = _aligned_malloc(size, align);
+            #else
+            void* p = std::aligned_alloc(align, size);
+            #endif
+            if (p)
+                return p;
+
+            std::new_handler handler = std::get_new_handler();
+            if (!handler)
+                throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void alignedFree(void* p) noexcept
+    {
+        #if defined(_MSC_VER)
+        _aligned_free(p);
+        #else
+        std::free(p);
+        #endif
+    }
+}
+
+void* operator new(std::size_t n)   { return countedAlloc(n); }
+void* operator new[](std::size_t n) { return countedAlloc(n); }
+
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept
+{
+    try { return countedAlloc(n); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept
+{
+    try { return countedAlloc(n); } catch (...) { return nullptr; }
+}
+
+void* operator new(std::size_t n, std::align_val_t al)   { return countedAlignedAlloc(n, al); }
+void* operator new[](std::size_t n, std::align_val_t al) { return countedAlignedAlloc(n, al); }
+
+void* operator new(std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+    try { return countedAlignedAlloc(n, al); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept
+{
+    try { return countedAlignedAlloc(n, al); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* p) noexcept                         { std::free(p); }
+void operator delete[](void* p) noexcept                       { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept            { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept          { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept   { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+void operator delete(void* p, std::align_val_t) noexcept                { alignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept              { alignedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept   { alignedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept   { alignedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(p); }
+
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+#include "sim_types.h"
+#include <atomic>
+
+SIM_BEG;
+
+using namespace bl;
+
+/// ─────── AllocCounter ───────
+//
+// Opt-in heap telemetry. Built with THREEBODY_COUNT_ALLOCATIONS (defines
+// SIM_COUNT_ALLOCATIONS), alloc_counter.cpp replaces the global operator
+// new/delete and counts every allocation, process-wide and per thread.
+// Without it the counters stay 0 and enabled() is false.
+//
+// Per-thread counts let a worker measure its own hot path, e.g. the scan
+// workers report allocations made while integrating pixels.
+
+struct AllocTelemetry
+{
+    std::atomic<u64> allocations{ 0 };
+    std::atomic<u64> bytes{ 0 };
+};
+
+inline AllocTelemetry& allocTelemetry()
+{
+    static AllocTelemetry telemetry;
+    return telemetry;
+}
+
+inline thread_local u64 thread_allocations = 0;
+
+struct AllocCounter
+{
+    static constexpr bool enabled()
+    {
+        #if SIM_COUNT_ALLOCATIONS
+        return true;
+        #else
+        return false;
+        #endif
+    }
+
+    static u64 total()      { return allocTelemetry().allocations.load(std::memory_order_relaxed); }
+    static u64 bytes()      { return allocTelemetry().bytes.load(std::memory_order_relaxed); }
+    static u64 thisThread() { return thread_allocations; }
+
+    static constexpr u64 atomics_per_record = 2; // read-modify-writes in record()
+
+    static void record(size_t n)
+    {
+        allocTelemetry().allocations.fetch_add(1, std::memory_order_relaxed);
+        allocTelemetry().bytes.fetch_add(n, std::memory_order_relaxed);
+        thread_allocations++;
+    }
+};
+
+SIM_END;
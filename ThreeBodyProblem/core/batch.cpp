@@ -0,0 +1,9 @@
+#include "batch.h"
+
+SIM_BEG;
+
+template size_t evaluateBatch<f64, StopPolicy_MaxDist>(const SimEnv<f64>&, std::span<const InitialConditions<f64>>, std::span<SimOutcome>, KernelISA);
+template size_t evaluateBatch<f64, StopPolicy_Periodic>(const SimEnv<f64>&, std::span<const InitialConditions<f64>>, std::span<SimOutcome>, KernelISA);
+template size_t evaluateBatch<f32, StopPolicy_MaxDist>(const SimEnv<f32>&, std::span<const InitialConditions<f32>>, std::span<SimOutcome>, KernelISA);
+
+SIM_END;
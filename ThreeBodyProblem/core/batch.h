@@ -0,0 +1,78 @@
+#pragma once
+#include "orbit_sim.h"
+#include <span>
+
+SIM_BEG;
+
+using namespace bl;
+
+/// ─────── Batch evaluation ───────
+//
+// Scene-free entry point for evaluating many initial conditions: fills
+// outcomes[i] with the stop result of conditions[i] under env. Work is split
+// into SimKernel::LANES sized chunks on a stack buffer, so a call allocates
+// nothing and never touches a thread pool; callers that want parallelism
+// split the span themselves and run one call per worker.
+//
+// Every condition is integrated: env.prefilter_unbound/prefilter_hierarchical
+// are ignored here (the analytic pre-filter is a SimGrid::run() step).
+//
+// Returns the number of outcomes written (min of both span sizes).
+
+template<class T>
+struct InitialConditions
+{
+    Vec2<T> pos[3];
+    Vec2<T> vel[3];
+};
+
+struct SimOutcome
+{
+    StopResult result;
+    i32 iters = 0;
+};
+
+template<class T, template<class> class StopPolicy = StopPolicy_MaxDist>
+size_t evaluateBatch(
+    const SimEnv<T>& env,
+    std::span<const InitialConditions<T>> conditions,
+    std::span<SimOutcome> outcomes,
+    KernelISA isa = KernelISA::AUTO)
+{
+    using Kernel = SimKernel<T, StopPolicy>;
+    using Sim = Sim<T, StopPolicy>;
+
+    const size_t count = std::min(conditions.size(), outcomes.size());
+    if (isa == KernelISA::AUTO)
+        isa = activeKernelISA();
+
+    Sim sims[Kernel::LANES];
+    for (size_t first = 0; first < count; first += Kernel::LANES)
+    {
+        const int n = (int)std::min<size_t>(Kernel::LANES, count - first);
+        for (int i = 0; i < n; i++)
+        {
+            const InitialConditions<T>& ic = conditions[first + i];
+            sims[i].setup(env, ic.pos, ic.vel);
+        }
+
+        Kernel::integrate(sims, n, env, isa);
+
+        for (int i = 0; i < n; i++)
+        {
+            SimOutcome& out = outcomes[first + i];
+            out.result = sims[i].stability();
+            out.iters = sims[i].curIter();
+        }
+    }
+    return count;
+}
+
+#ifdef SIM_CORE_STANDALONE
+// instantiated once in batch.cpp (ThreeBodyCore)
+extern template size_t evaluateBatch<f64, StopPolicy_MaxDist>(const SimEnv<f64>&, std::span<const InitialConditions<f64>>, std::span<SimOutcome>, KernelISA);
+extern template size_t evaluateBatch<f64, StopPolicy_Periodic>(const SimEnv<f64>&, std::span<const InitialConditions<f64>>, std::span<SimOutcome>, KernelISA);
+extern template size_t evaluateBatch<f32, StopPolicy_MaxDist>(const SimEnv<f32>&, std::span<const InitialConditions<f32>>, std::span<SimOutcome>, KernelISA);
+#endif
+
+SIM_END;
@@ -0,0 +1,154 @@
+#pragma once
+#include "orbit_sim.h"
+#include <array>
+#include <optional>
+#include <string>
+
+SIM_BEG;
+
+using namespace bl;
+
+/// ─────── OrbitContinuation ───────
+//
+// Follows a periodic orbit through parameter space with pseudo-arclength
+// continuation, instead of rescanning at every parameter value.
+//
+// An orbit is a shooting problem: find the starting state q and period T with
+// flow_T(q) = q. Bodies A and B keep their starting positions (this pins
+// translation, rotation and scale). The unknowns are
+//
+//   q       c.x, c.y, vb.x, vb.y, vc.x, vc.y  (va = -(vb + vc): zero momentum)
+//   T       period
+//   lambda  continuation parameter: G, softening, or c.x / c.y (then it
+//           replaces that component of q)
+//
+// Each step:
+//   1. finite-difference Jacobian of the 12 return residuals (the columns
+//      integrate in parallel)
+//   2. null directions from a Jacobi eigendecomposition of J^T J. With G or
+//      softening as lambda the orbit also sits in a family at fixed lambda
+//      (energy); that direction gets pinned, the remaining one is the tangent
+//   3. predictor along the tangent, then Gauss-Newton corrections that reuse
+//      the step's Jacobian (chord method) under the arclength and pin
+//      constraints
+//   4. step size grows after fast convergence and halves on failure
+//
+// The branch is kept as a compact series of BranchPoints. Folds are flagged
+// where the tangent's lambda component changes sign. Branch-point candidates
+// are flagged where the second smallest singular value reaches a local
+// minimum below branch_tolerance (a second null direction is opening). This
+// is a singular-value test on the shooting Jacobian, Floquet multipliers are
+// not computed.
+
+enum class ContinuationParam { G, SOFTENING, C_X, C_Y };
+
+struct BranchPoint
+{
+    static constexpr u32 FLAG_FOLD = 1;
+    static constexpr u32 FLAG_BRANCH = 2;
+
+    f64 lambda = 0;
+    f64 period = 0;   // time units
+    f64 q[6]{};       // c.x, c.y, vb.x, vb.y, vc.x, vc.y
+    f64 residual = 0; // |flow_T(q) - q|
+    f64 sigma2 = 0;   // second smallest singular value (branch test function)
+    u32 flags = 0;
+};
+
+template<class T>
+class OrbitContinuation
+{
+public:
+
+    using Env = SimEnv<T>;
+    using Vec = Vec2<T>;
+
+    static constexpr int MAX_VARS = 8;
+
+    struct Config
+    {
+        ContinuationParam param = ContinuationParam::SOFTENING;
+        f64 ds = 0.01;              // initial arclength step
+        f64 ds_min = 1e-6;
+        f64 ds_max = 0.1;
+        int direction = 1;          // +1 / -1: initial direction of lambda
+        f64 tolerance = 1e-8;       // max |residual| of a converged orbit
+        int max_corrections = 8;
+        f64 null_tolerance = 1e-5;   // relative singular value that counts as a null direction
+        f64 branch_tolerance = 1e-4; // relative sigma2 below which a dip counts as a branch candidate
+    };
+
+    // starts a branch from sim (positions of A and B are kept). The period is
+    // detected, then corrected at the starting parameter value.
+    // false if no period is found or the correction fails
+    template<class SimT>
+    bool start(const Env& env, const SimT& sim, const Config& cfg);
+
+    // one continuation step, false once the step size drops below ds_min
+    bool step();
+
+    // up to count steps, returns the number taken
+    int run(int count);
+
+    const std::vector<BranchPoint>& branch() const { return points; }
+    ContinuationParam param() const                 { return cfg.param; }
+
+    // env and starting state of branch point i
+    template<class SimT>
+    void restore(int i, Env& env_out, SimT& sim) const;
+
+    // binary: BranchHeader followed by BranchPoint[count]
+    bool save(const std::string& path) const;
+
+    struct BranchHeader
+    {
+        char magic[4] = { 'T', 'B', 'B', 'R' };
+        u32  version = 1;
+        u32  param = 0;
+        u32  count = 0;
+        f64  pos_a[2]{}, pos_b[2]{};
+    };
+
+private:
+
+    using Vars = std::array<f64, MAX_VARS>;
+
+    Config cfg;
+    std::optional<Env> base_env;
+    f64 pos_a[2]{}, pos_b[2]{};
+
+    int n_vars = 0;
+    int q_slot[6]{};    // variable index of each q component (-1 = lambda)
+    int t_slot = 0;     // variable index of T
+    int l_slot = 0;     // variable index of lambda
+
+    Vars v{};           // current solution
+    Vars tangent{};
+    Vars family_pin{};       // family pin (zero when the orbit is isolated at fixed lambda)
+    f64  ds = 0;
+    bool has_tangent = false;
+    f64  prev_sigma2[2] = { -1, -1 };
+
+    std::vector<BranchPoint> points;
+
+    void unpack(const Vars& x, f64 (&q)[6], f64& period, f64& lambda) const;
+    Env envFor(f64 lambda) const;
+    void residual(const Vars& x, f64 (&r)[12]) const;
+    void jacobian(const Vars& x, f64 (&r)[12], f64 (&J)[12][MAX_VARS]) const;
+
+    // family pin (zero if the orbit is isolated at fixed lambda), tangent
+    // direction and the branch test function (relative singular value)
+    void directions(const f64 (&J)[12][MAX_VARS], Vars& pin, Vars& dir, f64& sigma2) const;
+
+    // chord Gauss-Newton on R(x) = 0 with the constraints c1.x = d1, c2.x = d2
+    bool correct(Vars& x, const f64 (&J)[12][MAX_VARS],
+        const Vars& c1, f64 d1, const Vars& c2, f64 d2, f64& res, int& iterations) const;
+
+    void record(const Vars& x, f64 res, u32 flags);
+
+    static void jacobiEigen(int n, f64 (&a)[MAX_VARS][MAX_VARS], f64 (&vals)[MAX_VARS], f64 (&vecs)[MAX_VARS][MAX_VARS]);
+};
+
+SIM_END;
+
+#include "continuation.hpp"
@@ -0,0 +1,554 @@
+#include "continuation.h"
+#include <algorithm>
+#include <fstream>
+
+SIM_BEG;
+using namespace bl;
+
+template<class T>
+void OrbitContinuation<T>::unpack(const Vars& x, f64 (&q)[6], f64& period, f64& lambda) const
+{
+    lambda = x[l_slot];
+    period = x[t_slot];
+    for (int k = 0; k < 6; k++)
+        q[k] = (q_slot[k] < 0) ? lambda : x[q_slot[k]];
+}
+
+template<class T>
+typename OrbitContinuation<T>::Env OrbitContinuation<T>::envFor(f64 lambda) const
+{
+    Env env(*base_env);
+    switch (cfg.param)
+    {
+    case ContinuationParam::G:         env.G = T(lambda); break;
+    case ContinuationParam::SOFTENING: env.soft2 = T(lambda); break;
+    default: break;
+    }
+    return env;
+}
+
+template<class T>
+void OrbitContinuation<T>::residual(const Vars& x, f64 (&r)[12]) const
+{
+    f64 q[6], period, lambda;
+    unpack(x, q, period, lambda);
+
+    const Env env = envFor(lambda);
+    const Vec vb{ T(q[2]), T(q[3]) };
+    const Vec vc{ T(q[4]), T(q[5]) };
+    const Vec pos[3] = { Vec(T(pos_a[0]), T(pos_a[1])), Vec(T(pos_b[0]), T(pos_b[1])), Vec(T(q[0]), T(q[1])) };
+    const Vec vel[3] = { Vec() - (vb + vc), vb, vc };
+
+    Sim<T, StopPolicy_None> sim;
+    sim.setup(env, pos, vel);
+
+    // whole steps, then one partial step so the flow is continuous in the period
+    const f64 dt = (f64)env.dt;
+    const int steps = (int)std::floor(std::max(0.0, period) / dt);
+    for (int i = 0; i < steps; i++)
+        sim.progress(env);
+
+    const f64 remainder = period - steps * dt;
+    if (remainder > 0)
+    {
+        Env partial(env);
+        partial.dt = T(remainder);
+        sim.progress(partial);
+    }
+
+    const Particle<T>* p[3] = { &sim.bodyA(), &sim.bodyB(), &sim.bodyC() };
+    for (int i = 0; i < 3; i++)
+    {
+        r[i * 2 + 0] = (f64)p[i]->x - (f64)pos[i].x;
+        r[i * 2 + 1] = (f64)p[i]->y - (f64)pos[i].y;
+        r[6 + i * 2 + 0] = (f64)p[i]->vx - (f64)vel[i].x;
+        r[6 + i * 2 + 1] = (f64)p[i]->vy - (f64)vel[i].y;
+    }
+}
+
+template<class T>
+void OrbitContinuation<T>::jacobian(const Vars& x, f64 (&r)[12], f64 (&J)[12][MAX_VARS]) const
+{
+    // forward differences, one integration per column (in parallel)
+    f64 cols[MAX_VARS][12];
+    f64 h[MAX_VARS];
+
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(n_vars);
+    for (int j = 0; j < n_vars; j++)
+    {
+        h[j] = 1e-7 * std::max(1.0, std::abs(x[j]));
+        tasks.push_back(submitSimTask([this, &x, &cols, &h, j]() {
+            Vars xh = x;
+            xh[j] += h[j];
+            residual(xh, cols[j]);
+        }));
+    }
+    residual(x, r);
+    for (auto& task : tasks)
+        task.get();
+
+    for (int j = 0; j < n_vars; j++)
+        for (int i = 0; i < 12; i++)
+            J[i][j] = (cols[j][i] - r[i]) / h[j];
+}
+
+/// ─────── Linear algebra ───────
+
+template<class T>
+void OrbitContinuation<T>::jacobiEigen(int n, f64 (&a)[MAX_VARS][MAX_VARS], f64 (&vals)[MAX_VARS], f64 (&vecs)[MAX_VARS][MAX_VARS])
+{
+    // cyclic Jacobi rotations, eigenvectors in the columns of vecs, ascending
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            vecs[i][j] = (i == j) ? 1.0 : 0.0;
+
+    for (int sweep = 0; sweep < 64; sweep++)
+    {
+        f64 off = 0;
+        for (int p = 0; p < n; p++)
+            for (int q = p + 1; q < n; q++)
+                off += a[p][q] * a[p][q];
+        if (off < 1e-30)
+            break;
+
+        for (int p = 0; p < n; p++)
+        {
+            for (int q = p + 1; q < n; q++)
+            {
+                if (a[p][q] == 0)
+                    continue;
+
+                const f64 theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+                const f64 t = (theta >= 0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+                const f64 c = 1 / std::sqrt(t * t + 1);
+                const f64 s = t * c;
+
+                for (int k = 0; k < n; k++)
+                {
+                    const f64 akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < n; k++)
+                {
+                    const f64 apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < n; k++)
+                {
+                    const f64 vkp = vecs[k][p], vkq = vecs[k][q];
+                    vecs[k][p] = c * vkp - s * vkq;
+                    vecs[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    // selection sort by eigenvalue
+    for (int i = 0; i < n; i++)
+        vals[i] = a[i][i];
+    for (int i = 0; i < n; i++)
+    {
+        int m = i;
+        for (int j = i + 1; j < n; j++)
+            if (vals[j] < vals[m]) m = j;
+        if (m == i)
+            continue;
+        std::swap(vals[i], vals[m]);
+        for (int k = 0; k < n; k++)
+            std::swap(vecs[k][i], vecs[k][m]);
+    }
+}
+
+template<class T>
+void OrbitContinuation<T>::directions(const f64 (&J)[12][MAX_VARS], Vars& pin, Vars& dir, f64& sigma2) const
+{
+    const int n = n_vars;
+    f64 JtJ[MAX_VARS][MAX_VARS]{};
+    f64 trace = 0;
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+            for (int k = 0; k < 12; k++)
+                JtJ[i][j] += J[k][i] * J[k][j];
+        trace += JtJ[i][i];
+    }
+
+    f64 vals[MAX_VARS], vecs[MAX_VARS][MAX_VARS];
+    auto smallest = [&](const Vars& penalised, Vars& out)
+    {
+        // penalise a direction on the scale of J
+        const f64 w = std::max(trace / n, 1e-300);
+        f64 M[MAX_VARS][MAX_VARS];
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++)
+                M[i][j] = JtJ[i][j] + w * penalised[i] * penalised[j];
+
+        jacobiEigen(n, M, vals, vecs);
+        out.fill(0);
+        for (int i = 0; i < n; i++)
+            out[i] = vecs[i][0];
+    };
+
+    auto relSigma = [&](int k) {
+        return std::sqrt(std::max(vals[k], 0.0) / std::max(vals[n - 1], 1e-300));
+    };
+
+    // a second null direction means the orbit sits in a family at fixed lambda
+    // (e.g. energy), which gets pinned at its current member
+    Vars none{};
+    Vars unused;
+    smallest(none, unused);
+
+    pin.fill(0);
+    if (relSigma(1) < cfg.null_tolerance)
+    {
+        Vars e_l{};
+        e_l[l_slot] = 1;
+        smallest(e_l, pin);
+    }
+
+    smallest(pin, dir);
+    sigma2 = relSigma(1);
+}
+
+template<class T>
+bool OrbitContinuation<T>::correct(Vars& x, const f64 (&J)[12][MAX_VARS],
+    const Vars& c1, f64 d1, const Vars& c2, f64 d2, f64& res, int& iterations) const
+{
+    const int n = n_vars;
+    constexpr int ROWS = 14;
+
+    // A = [J; W c1; W c2], W puts the constraints on the scale of J
+    f64 A[ROWS][MAX_VARS]{};
+    f64 trace = 0;
+    for (int i = 0; i < 12; i++)
+        for (int j = 0; j < n; j++)
+        {
+            A[i][j] = J[i][j];
+            trace += J[i][j] * J[i][j];
+        }
+    const f64 W = std::sqrt(std::max(trace / n, 1e-300));
+    for (int j = 0; j < n; j++)
+    {
+        A[12][j] = W * c1[j];
+        A[13][j] = W * c2[j];
+    }
+
+    // chord method: one pseudo-inverse of A^T A for every iteration
+    f64 M[MAX_VARS][MAX_VARS]{};
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            for (int k = 0; k < ROWS; k++)
+                M[i][j] += A[k][i] * A[k][j];
+
+    f64 vals[MAX_VARS], vecs[MAX_VARS][MAX_VARS];
+    jacobiEigen(n, M, vals, vecs);
+    const f64 cutoff = std::max(vals[n - 1], 1e-300) * 1e-14;
+
+    auto dot = [n](const Vars& a, const Vars& b) {
+        f64 s = 0;
+        for (int i = 0; i < n; i++) s += a[i] * b[i];
+        return s;
+    };
+
+    f64 prev_res = std::numeric_limits<f64>::infinity();
+    for (iterations = 0; iterations <= cfg.max_corrections; iterations++)
+    {
+        if (x[t_slot] <= (f64)base_env->dt)
+            return false;
+
+        f64 R[12], F[ROWS];
+        residual(x, R);
+        std::copy(R, R + 12, F);
+        F[12] = W * (dot(c1, x) - d1);
+        F[13] = W * (dot(c2, x) - d2);
+
+        res = 0;
+        for (int i = 0; i < 12; i++)
+            res = std::max(res, std::abs(F[i]));
+
+        if (!std::isfinite(res) || res > 2 * prev_res)
+            return false;
+
+        const f64 constraint = std::max(std::abs(F[12]), std::abs(F[13])) / W;
+        if (res <= cfg.tolerance && constraint <= cfg.tolerance)
+            return true;
+        prev_res = res;
+
+        // dx = -(A^T A)^+ A^T F
+        f64 g[MAX_VARS]{};
+        for (int j = 0; j < n; j++)
+            for (int k = 0; k < ROWS; k++)
+                g[j] += A[k][j] * F[k];
+
+        for (int e = 0; e < n; e++)
+        {
+            if (vals[e] <= cutoff)
+                continue;
+            f64 proj = 0;
+            for (int j = 0; j < n; j++)
+                proj += vecs[j][e] * g[j];
+            proj /= vals[e];
+            for (int j = 0; j < n; j++)
+                x[j] -= proj * vecs[j][e];
+        }
+    }
+    return false;
+}
+
+/// ─────── Continuation ───────
+
+template<class T>
+void OrbitContinuation<T>::record(const Vars& x, f64 res, u32 flags)
+{
+    BranchPoint p;
+    unpack(x, p.q, p.period, p.lambda);
+    p.residual = res;
+    p.flags = flags;
+    points.push_back(p);
+}
+
+template<class T>
+template<class SimT>
+bool OrbitContinuation<T>::start(const Env& env, const SimT& src, const Config& config)
+{
+    cfg = config;
+    base_env.emplace(env);
+    points.clear();
+    has_tangent = false;
+    ds = cfg.ds;
+
+    // work in the centre-of-mass frame, so va = -(vb + vc) holds
+    const Particle<T>* p[3] = { &src.bodyA(), &src.bodyB(), &src.bodyC() };
+    f64 com[4]{};
+    for (int i = 0; i < 3; i++)
+    {
+        com[0] += (f64)p[i]->x / 3;  com[1] += (f64)p[i]->y / 3;
+        com[2] += (f64)p[i]->vx / 3; com[3] += (f64)p[i]->vy / 3;
+    }
+    Vec pos[3], vel[3];
+    for (int i = 0; i < 3; i++)
+    {
+        pos[i] = Vec(T((f64)p[i]->x - com[0]), T((f64)p[i]->y - com[1]));
+        vel[i] = Vec(T((f64)p[i]->vx - com[2]), T((f64)p[i]->vy - com[3]));
+    }
+
+    // period estimate, starting on the recurrence (past any transient)
+    int period_iters = 0;
+    {
+        Sim<T, StopPolicy_None> sim;
+        sim.setup(env, pos, vel);
+
+        PeriodDetector<T> detector;
+        const T vel_quantum = env.vel_tolerance > T(0) ? env.vel_tolerance : env.pos_tolerance;
+        detector.init(env.pos_tolerance, vel_quantum, 16);
+
+        // the recurrence starts on a section crossing, so only those states are kept
+        struct Crossing { int iter; Particle<T> p[3]; };
+        std::vector<Crossing> crossings;
+        for (int i = 1; i <= env.max_iter; i++)
+        {
+            sim.progress(env);
+            const int seen = detector.crossingCount();
+            const bool found = detector.observe(i, sim.bodyA(), sim.bodyB(), sim.bodyC());
+            if (detector.crossingCount() != seen)
+                crossings.push_back({ i, { sim.bodyA(), sim.bodyB(), sim.bodyC() } });
+            if (found)
+                break;
+        }
+        period_iters = detector.periodIters();
+        if (period_iters <= 0)
+            return false;
+
+        auto beg = std::find_if(crossings.begin(), crossings.end(),
+            [&detector](const Crossing& x) { return x.iter == detector.periodStart(); });
+        if (beg == crossings.end())
+            return false;
+
+        for (int i = 0; i < 3; i++)
+        {
+            pos[i] = Vec(beg->p[i].x, beg->p[i].y);
+            vel[i] = Vec(beg->p[i].vx, beg->p[i].vy);
+        }
+    }
+
+    pos_a[0] = (f64)pos[0].x; pos_a[1] = (f64)pos[0].y;
+    pos_b[0] = (f64)pos[1].x; pos_b[1] = (f64)pos[1].y;
+
+    const f64 q[6] = {
+        (f64)pos[2].x, (f64)pos[2].y,
+        (f64)vel[1].x, (f64)vel[1].y,
+        (f64)vel[2].x, (f64)vel[2].y
+    };
+
+    f64 lambda = 0;
+    switch (cfg.param)
+    {
+    case ContinuationParam::G:         lambda = (f64)env.G; break;
+    case ContinuationParam::SOFTENING: lambda = (f64)env.soft2; break;
+    case ContinuationParam::C_X:       lambda = q[0]; break;
+    case ContinuationParam::C_Y:       lambda = q[1]; break;
+    }
+
+    n_vars = 0;
+    for (int k = 0; k < 6; k++)
+    {
+        const bool is_lambda = (cfg.param == ContinuationParam::C_X && k == 0) ||
+                               (cfg.param == ContinuationParam::C_Y && k == 1);
+        q_slot[k] = is_lambda ? -1 : n_vars++;
+    }
+    t_slot = n_vars++;
+    l_slot = n_vars++;
+
+    v.fill(0);
+    for (int k = 0; k < 6; k++)
+        if (q_slot[k] >= 0) v[q_slot[k]] = q[k];
+    v[t_slot] = period_iters * (f64)env.dt;
+    v[l_slot] = lambda;
+
+    // correct at fixed lambda, refreshing the Jacobian between chord runs
+    Vars e_l{};
+    e_l[l_slot] = 1;
+    for (int round = 0; round < 4; round++)
+    {
+        f64 r[12], J[12][MAX_VARS];
+        jacobian(v, r, J);
+
+        Vars t;
+        f64 sigma2;
+        directions(J, family_pin, t, sigma2);
+
+        f64 pin_d = 0;
+        for (int i = 0; i < n_vars; i++)
+            pin_d += family_pin[i] * v[i];
+
+        Vars x = v;
+        f64 res;
+        int iterations;
+        const bool converged = correct(x, J, family_pin, pin_d, e_l, lambda, res, iterations);
+        if (x[t_slot] > (f64)env.dt)
+            v = x;
+
+        if (converged)
+        {
+            record(v, res, 0);
+            return true;
+        }
+    }
+    return false;
+}
+
+template<class T>
+bool OrbitContinuation<T>::step()
+{
+    if (points.empty())
+        return false;
+
+    f64 r[12], J[12][MAX_VARS];
+    jacobian(v, r, J);
+
+    auto dot = [this](const Vars& a, const Vars& b) {
+        f64 s = 0;
+        for (int i = 0; i < n_vars; i++) s += a[i] * b[i];
+        return s;
+    };
+
+    Vars t;
+    f64 sigma2;
+    directions(J, family_pin, t, sigma2);
+
+    const bool flip = has_tangent ? (dot(t, tangent) < 0) : (t[l_slot] * cfg.direction < 0);
+    if (flip)
+        for (int i = 0; i < n_vars; i++) t[i] = -t[i];
+
+    const bool fold = has_tangent && (t[l_slot] * tangent[l_slot] < 0);
+    tangent = t;
+    has_tangent = true;
+
+    // branch test function belongs to the current point, candidates are local minima
+    points.back().sigma2 = sigma2;
+    const size_t n = points.size();
+    if (n >= 3)
+    {
+        BranchPoint& mid = points[n - 2];
+        if (mid.sigma2 < cfg.branch_tolerance &&
+            mid.sigma2 < points[n - 3].sigma2 &&
+            mid.sigma2 <= points[n - 1].sigma2 &&
+            mid.sigma2 * 2 < std::max(points[n - 3].sigma2, points[n - 1].sigma2))
+        {
+            mid.flags |= BranchPoint::FLAG_BRANCH;
+        }
+    }
+
+    while (ds >= cfg.ds_min)
+    {
+        Vars x = v;
+        for (int i = 0; i < n_vars; i++)
+            x[i] += ds * tangent[i];
+
+        f64 res;
+        int iterations;
+        if (correct(x, J, family_pin, dot(family_pin, v), tangent, dot(tangent, x), res, iterations))
+        {
+            v = x;
+            record(v, res, fold ? BranchPoint::FLAG_FOLD : 0);
+
+            if (iterations <= 2)
+                ds = std::min(ds * 1.5, cfg.ds_max);
+            return true;
+        }
+        ds *= 0.5;
+    }
+    return false;
+}
+
+template<class T>
+int OrbitContinuation<T>::run(int count)
+{
+    int taken = 0;
+    while (taken < count && step())
+        taken++;
+    return taken;
+}
+
+template<class T>
+template<class SimT>
+void OrbitContinuation<T>::restore(int i, Env& env, SimT& sim) const
+{
+    const BranchPoint& p = points[std::clamp(i, 0, (int)points.size() - 1)];
+    switch (cfg.param)
+    {
+    case ContinuationParam::G:         env.G = T(p.lambda); break;
+    case ContinuationParam::SOFTENING: env.soft2 = T(p.lambda); break;
+    default: break;
+    }
+
+    const Vec vb{ T(p.q[2]), T(p.q[3]) };
+    const Vec vc{ T(p.q[4]), T(p.q[5]) };
+    const Vec pos[3] = { Vec(T(pos_a[0]), T(pos_a[1])), Vec(T(pos_b[0]), T(pos_b[1])), Vec(T(p.q[0]), T(p.q[1])) };
+    const Vec vel[3] = { Vec() - (vb + vc), vb, vc };
+    sim.setup(env, pos, vel);
+}
+
+template<class T>
+bool OrbitContinuation<T>::save(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        return false;
+
+    BranchHeader header;
+    header.param = (u32)cfg.param;
+    header.count = (u32)points.size();
+    header.pos_a[0] = pos_a[0]; header.pos_a[1] = pos_a[1];
+    header.pos_b[0] = pos_b[0]; header.pos_b[1] = pos_b[1];
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(points.data()), (std::streamsize)(points.size() * sizeof(BranchPoint)));
+    return (bool)out;
+}
+
+SIM_END;
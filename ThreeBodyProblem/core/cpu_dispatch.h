@@ -0,0 +1,246 @@
+#pragma once
+#include "sim_types.h"
+#include <atomic>
+
+// wasm can't dispatch at runtime (a module using simd128 fails to validate on
+// engines without it), so -msimd128 builds make simd128 the baseline variant
+#if defined(__wasm_simd128__)
+#define SIM_WASM_SIMD128 1
+#include <wasm_simd128.h>
+#else
+#define SIM_WASM_SIMD128 0
+#endif
+
+/// ─────── kernel ISA variants ───────
+//
+// The hot integration kernels are compiled several times with per-function
+// target attributes (not per-TU flags, so no AVX code can leak into shared
+// inline functions through the linker). The best variant the CPU supports is
+// picked once at startup.
+//
+// MSVC has no per-function target attribute, so only the baseline variant is
+// built there (use /arch to raise the baseline).
+
+#if !defined(__EMSCRIPTEN__) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SIM_KERNEL_DISPATCH 1
+#else
+#define SIM_KERNEL_DISPATCH 0
+#endif
+
+#if SIM_KERNEL_DISPATCH
+    // SIM_DETERMINISTIC drops FMA from the wide variants so every variant
+    // produces bit-identical results (the build also disables contraction)
+    #ifdef SIM_DETERMINISTIC
+    #define SIM_TARGET_AVX2_ISA   "avx2"
+    #define SIM_TARGET_AVX512_ISA "avx512f,avx512dq,avx512vl,avx2"
+    #else
+    #define SIM_TARGET_AVX2_ISA   "avx2,fma"
+    #define SIM_TARGET_AVX512_ISA "avx512f,avx512dq,avx512vl,avx2,fma"
+    #endif
+
+    // flatten: inline the whole call tree so it is generated for the variant's ISA
+    #define SIM_TARGET_BASE   __attribute__((flatten))
+    #define SIM_TARGET_AVX2   __attribute__((target(SIM_TARGET_AVX2_ISA), flatten))
+    #define SIM_TARGET_AVX512 __attribute__((target(SIM_TARGET_AVX512_ISA), flatten))
+#else
+    #define SIM_TARGET_BASE
+    #define SIM_TARGET_AVX2
+    #define SIM_TARGET_AVX512
+#endif
+
+SIM_BEG;
+
+using namespace bl;
+
+enum class KernelISA
+{
+    AUTO = -1,
+    SSE2,     // baseline (whatever the build targets, simd128 on wasm)
+    AVX2,     // AVX2 (+FMA unless deterministic)
+    AVX512,   // AVX-512 F/DQ/VL
+
+    COUNT
+};
+
+inline const char* kernelISAName(KernelISA isa)
+{
+    switch (isa)
+    {
+    case KernelISA::AUTO:   return "Auto";
+    #if SIM_WASM_SIMD128
+    case KernelISA::SSE2:   return "simd128 (wasm)";
+    #elif defined(__EMSCRIPTEN__)
+    case KernelISA::SSE2:   return "scalar (wasm)";
+    #else
+    case KernelISA::SSE2:   return "SSE2 (baseline)";
+    #endif
+    #ifdef SIM_DETERMINISTIC
+    case KernelISA::AVX2:   return "AVX2";
+    case KernelISA::AVX512: return "AVX-512";
+    #else
+    case KernelISA::AVX2:   return "AVX2+FMA";
+    case KernelISA::AVX512: return "AVX-512+FMA";
+    #endif
+    default:                return "?";
+    }
+}
+
+struct CpuFeatures
+{
+    bool avx2 = false;
+    bool fma = false;
+    bool avx512 = false; // F + DQ + VL, with OS support for the ZMM state
+};
+
+// Only consulted when SIM_KERNEL_DISPATCH builds the wider variants (GCC/Clang
+// on x86), other builds report no features
+inline CpuFeatures detectCpuFeatures()
+{
+    CpuFeatures f;
+    #if SIM_KERNEL_DISPATCH
+    __builtin_cpu_init();
+    f.avx2   = __builtin_cpu_supports("avx2");
+    f.fma    = __builtin_cpu_supports("fma");
+    f.avx512 = __builtin_cpu_supports("avx512f") &&
+               __builtin_cpu_supports("avx512dq") &&
+               __builtin_cpu_supports("avx512vl");
+    #endif
+    return f;
+}
+
+// Best variant that is both compiled in and supported by this CPU
+inline KernelISA bestKernelISA()
+{
+    static const KernelISA best = []
+    {
+        #if SIM_KERNEL_DISPATCH
+        const CpuFeatures f = detectCpuFeatures();
+        #ifdef SIM_DETERMINISTIC
+        const bool fma_ok = true;
+        #else
+        const bool fma_ok = f.fma;
+        #endif
+        if (f.avx512 && fma_ok) return KernelISA::AVX512;
+        if (f.avx2 && fma_ok)   return KernelISA::AVX2;
+        #endif
+        return KernelISA::SSE2;
+    }();
+    return best;
+}
+
+inline std::atomic<int>& kernelISAOverride()
+{
+    static std::atomic<int> isa{ (int)KernelISA::AUTO };
+    return isa;
+}
+
+// Force a variant (e.g. to compare results across ISAs). Requests above
+// bestKernelISA() are clamped, so an override can never fault.
+inline void setKernelISAOverride(KernelISA isa)
+{
+    kernelISAOverride().store((int)isa, std::memory_order_relaxed);
+}
+
+inline KernelISA activeKernelISA()
+{
+    const int forced = kernelISAOverride().load(std::memory_order_relaxed);
+    const KernelISA best = bestKernelISA();
+    if (forced == (int)KernelISA::AUTO) return best;
+    return (KernelISA)std::min(forced, (int)best);
+}
+
+/// ─────── telemetry ───────
+//
+// record() adds to the calling thread's tally, flush() moves a tally into the
+// shared counters (the only atomics). Threads flush on every record() unless
+// they hold a KernelTelemetryDeferral, the scan workers flush once per tile.
+
+struct KernelTally
+{
+    u64 batches[(int)KernelISA::COUNT]{};
+    u64 sims[(int)KernelISA::COUNT]{};
+    u64 steps[(int)KernelISA::COUNT]{};
+    bool deferred = false;
+};
+
+inline thread_local KernelTally kernel_tally;
+
+struct KernelTelemetry
+{
+    std::atomic<u64> batches[(int)KernelISA::COUNT]{};
+    std::atomic<u64> sims[(int)KernelISA::COUNT]{};
+    std::atomic<u64> steps[(int)KernelISA::COUNT]{};
+
+    void record(KernelISA isa, int sim_count, u64 lane_steps)
+    {
+        KernelTally& t = kernel_tally;
+        t.batches[(int)isa]++;
+        t.sims[(int)isa] += sim_count;
+        t.steps[(int)isa] += lane_steps;
+        if (!t.deferred)
+            flush();
+    }
+
+    // moves the calling thread's tally into the counters, returns the atomic
+    // read-modify-writes that took
+    u64 flush()
+    {
+        KernelTally& t = kernel_tally;
+        u64 atomics = 0;
+        for (int i = 0; i < (int)KernelISA::COUNT; i++)
+        {
+            if (t.batches[i] == 0) continue;
+            batches[i].fetch_add(t.batches[i], std::memory_order_relaxed);
+            sims[i].fetch_add(t.sims[i], std::memory_order_relaxed);
+            steps[i].fetch_add(t.steps[i], std::memory_order_relaxed);
+            t.batches[i] = t.sims[i] = t.steps[i] = 0;
+            atomics += 3;
+        }
+        return atomics;
+    }
+};
+
+inline KernelTelemetry& kernelTelemetry()
+{
+    static KernelTelemetry telemetry;
+    return telemetry;
+}
+
+// Holds the calling thread's kernel telemetry until kernelTelemetry().flush()
+// (and flushes whatever is left when it goes out of scope)
+struct KernelTelemetryDeferral
+{
+    KernelTelemetryDeferral()  { kernel_tally.deferred = true; }
+    ~KernelTelemetryDeferral() { kernelTelemetry().flush(); kernel_tally.deferred = false; }
+
+    KernelTelemetryDeferral(const KernelTelemetryDeferral&) = delete;
+    KernelTelemetryDeferral& operator=(const KernelTelemetryDeferral&) = delete;
+};
+
+// Plain copy of the counters for the UI
+struct KernelStats
+{
+    KernelISA active = KernelISA::SSE2;
+    KernelISA best = KernelISA::SSE2;
+    u64 batches[(int)KernelISA::COUNT]{};
+    u64 sims[(int)KernelISA::COUNT]{};
+    u64 steps[(int)KernelISA::COUNT]{};
+
+    static KernelStats snapshot()
+    {
+        KernelStats s;
+        s.active = activeKernelISA();
+        s.best = bestKernelISA();
+        const KernelTelemetry& t = kernelTelemetry();
+        for (int i = 0; i < (int)KernelISA::COUNT; i++)
+        {
+            s.batches[i] = t.batches[i].load(std::memory_order_relaxed);
+            s.sims[i] = t.sims[i].load(std::memory_order_relaxed);
+            s.steps[i] = t.steps[i].load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+};
+
+SIM_END;
@@ -0,0 +1,158 @@
+#pragma once
+#include "sim_types.h"
+#include <cmath>
+#include <limits>
+
+/// ─────── double-double ───────
+//
+// ~106-bit significand float made of an unevaluated sum hi + lo of two f64s
+// (|lo| <= ulp(hi)/2). It drops into Sim / SimGrid / SimEnv as T for
+// verification runs, where f64 rounding would decide a chaotic outcome.
+//
+// Every operation is branch-free f64 arithmetic (two-sum / FMA two-product),
+// so the lane kernels still vectorize across sims with T = ddouble.
+//
+// Requires IEEE f64 semantics: never build with -ffast-math (reassociation
+// cancels the error terms). Contraction is harmless.
+//
+// sqrt/abs/etc. live in ddmath (outside the sim namespace) so ADL finds them
+// without hiding the f64 overloads from unqualified calls in sim code.
+
+namespace ddmath {
+
+using bl::f32;
+using bl::f64;
+
+struct ddouble
+{
+    f64 hi = 0.0, lo = 0.0;
+
+    constexpr ddouble() = default;
+    constexpr ddouble(f64 v) : hi(v), lo(0.0) {}
+    constexpr ddouble(f32 v) : hi((f64)v), lo(0.0) {}
+    constexpr ddouble(int v) : hi((f64)v), lo(0.0) {}
+    constexpr ddouble(f64 _hi, f64 _lo) : hi(_hi), lo(_lo) {}
+
+    explicit constexpr operator f64() const { return hi + lo; }
+    explicit constexpr operator f32() const { return (f32)(hi + lo); }
+    explicit constexpr operator int() const { return (int)(hi + lo); }
+
+    // error-free transformations
+    static constexpr ddouble twoSum(f64 a, f64 b)
+    {
+        const f64 s = a + b;
+        const f64 bb = s - a;
+        return { s, (a - (s - bb)) + (b - bb) };
+    }
+    static constexpr ddouble quickTwoSum(f64 a, f64 b) // requires |a| >= |b|
+    {
+        const f64 s = a + b;
+        return { s, b - (s - a) };
+    }
+    static ddouble twoProd(f64 a, f64 b)
+    {
+        const f64 p = a * b;
+        return { p, std::fma(a, b, -p) };
+    }
+
+    friend constexpr ddouble operator-(const ddouble& a) { return { -a.hi, -a.lo }; }
+
+    friend constexpr ddouble operator+(const ddouble& a, const ddouble& b)
+    {
+        // accurate (IEEE-style) addition
+        ddouble s = twoSum(a.hi, b.hi);
+        const ddouble t = twoSum(a.lo, b.lo);
+        s.lo += t.hi;
+        s = quickTwoSum(s.hi, s.lo);
+        s.lo += t.lo;
+        return quickTwoSum(s.hi, s.lo);
+    }
+    friend constexpr ddouble operator-(const ddouble& a, const ddouble& b) { return a + (-b); }
+
+    friend ddouble operator*(const ddouble& a, const ddouble& b)
+    {
+        ddouble p = twoProd(a.hi, b.hi);
+        p.lo += a.hi * b.lo + a.lo * b.hi;
+        return quickTwoSum(p.hi, p.lo);
+    }
+
+    friend ddouble operator/(const ddouble& a, const ddouble& b)
+    {
+        // long division, two correction terms
+        const f64 q1 = a.hi / b.hi;
+        ddouble r = a - b * ddouble(q1);
+        const f64 q2 = r.hi / b.hi;
+        r = r - b * ddouble(q2);
+        const f64 q3 = r.hi / b.hi;
+        return quickTwoSum(q1, q2) + ddouble(q3);
+    }
+
+    ddouble& operator+=(const ddouble& b) { return *this = *this + b; }
+    ddouble& operator-=(const ddouble& b) { return *this = *this - b; }
+    ddouble& operator*=(const ddouble& b) { return *this = *this * b; }
+    ddouble& operator/=(const ddouble& b) { return *this = *this / b; }
+
+    friend constexpr bool operator==(const ddouble& a, const ddouble& b) { return a.hi == b.hi && a.lo == b.lo; }
+    friend constexpr bool operator!=(const ddouble& a, const ddouble& b) { return !(a == b); }
+    friend constexpr bool operator<(const ddouble& a, const ddouble& b)  { return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo); }
+    friend constexpr bool operator>(const ddouble& a, const ddouble& b)  { return b < a; }
+    friend constexpr bool operator<=(const ddouble& a, const ddouble& b) { return !(b < a); }
+    friend constexpr bool operator>=(const ddouble& a, const ddouble& b) { return !(a < b); }
+};
+
+inline ddouble abs(const ddouble& a)  { return a.hi < 0.0 ? -a : a; }
+inline ddouble fabs(const ddouble& a) { return abs(a); }
+
+inline ddouble sqrt(const ddouble& a)
+{
+    // one Newton step from the f64 root doubles the precision (Karp's trick)
+    const f64 x = std::sqrt(a.hi);
+    const ddouble xx = ddouble::twoProd(x, x);
+    const f64 corr = (a - xx).hi * (0.5 / x);
+    const ddouble r = ddouble::quickTwoSum(x, corr);
+    return a.hi > 0.0 ? r : ddouble(x); // 0, negatives (NaN) and inf fall back to f64
+}
+
+inline bool isfinite(const ddouble& a) { return std::isfinite(a.hi); }
+inline bool isnan(const ddouble& a)    { return std::isnan(a.hi); }
+
+} // namespace ddmath
+
+namespace std {
+
+template<>
+class numeric_limits<ddmath::ddouble>
+{
+    using dd = ddmath::ddouble;
+    using f64_limits = std::numeric_limits<double>;
+
+public:
+
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr int  radix = 2;
+    static constexpr int  digits = 2 * f64_limits::digits; // 106
+    static constexpr int  digits10 = 31;
+    static constexpr int  max_digits10 = 33;
+    static constexpr int  min_exponent = f64_limits::min_exponent + f64_limits::digits;
+    static constexpr int  max_exponent = f64_limits::max_exponent;
+
+    static constexpr dd min() noexcept           { return dd(f64_limits::min() * 0x1p53); } // keeps lo normal
+    static constexpr dd max() noexcept           { return dd(f64_limits::max()); }
+    static constexpr dd lowest() noexcept        { return -max(); }
+    static constexpr dd epsilon() noexcept       { return dd(0x1p-104); }
+    static constexpr dd infinity() noexcept      { return dd(f64_limits::infinity()); }
+    static constexpr dd quiet_NaN() noexcept     { return dd(f64_limits::quiet_NaN()); }
+};
+
+} // namespace std
+
+SIM_BEG;
+
+using ddmath::ddouble;
+
+SIM_END;
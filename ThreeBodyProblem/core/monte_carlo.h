@@ -0,0 +1,167 @@
+#pragma once
+#include "batch.h"
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <random>
+
+SIM_BEG;
+
+using namespace bl;
+
+/// ─────── Sampling ───────
+
+// Sobol low-discrepancy sequence (Joe & Kuo direction numbers), points are
+// produced in Gray-code order. A non-zero seed applies a random digital shift
+// (XOR), which keeps the equidistribution but gives independent replicas.
+class SobolSequence
+{
+public:
+
+    static constexpr int MAX_DIMS = 8;
+    static constexpr int BITS = 32;
+
+    explicit SobolSequence(int dims = MAX_DIMS, u64 seed = 0);
+
+    void next(f64* out); // writes dims() values in [0, 1)
+    int  dims() const    { return n_dims; }
+    u32  index() const   { return n; }
+
+private:
+
+    int n_dims;
+    u32 n = 0;
+    u32 dir[MAX_DIMS][BITS];
+    u32 x[MAX_DIMS]{};
+    u32 shift[MAX_DIMS]{};
+};
+
+// Wilson score interval for a binomial proportion (well behaved near 0 and 1)
+struct ProportionEstimate
+{
+    i64 hits = 0, trials = 0;
+    f64 p = 0, lo = 0, hi = 1;
+
+    f64 halfWidth() const { return (hi - lo) * 0.5; }
+};
+
+inline ProportionEstimate wilsonInterval(i64 hits, i64 trials, f64 z);
+
+// two-sided normal quantile, e.g. 0.95 -> 1.96
+inline f64 confidenceZ(f64 confidence);
+
+/// ─────── MonteCarlo ───────
+//
+// Aggregate statistics over a region of initial conditions without a full
+// scan: samples (C position, relative velocities u, w) uniformly at random or
+// from a Sobol sequence, integrates them in batches with evaluateBatch() on
+// worker tasks, and keeps running estimates with confidence intervals:
+//
+//   survival   fraction of samples that reach env.max_iter (or are STABLE
+//              under policies that detect stability), Wilson interval
+//   escape     mean survival iterations (normal interval) and a histogram
+//              of escape iterations over [0, max_iter)
+//
+// Sampling stops once the survival interval is narrower than the requested
+// half width (after min_samples), or at max_samples. Diverged sims are counted
+// but left out of every estimate.
+//
+// Sobol intervals use the same binomial formula and are conservative: the
+// error of a low-discrepancy estimate shrinks faster than 1/sqrt(n).
+
+enum class MonteCarloSampling { RANDOM, SOBOL };
+
+template<class T, template<class> class StopPolicy = StopPolicy_MaxDist>
+class MonteCarlo
+{
+public:
+
+    using Env = SimEnv<T>;
+    using Vec = Vec2<T>;
+
+    static constexpr int SAMPLE_DIMS = 6; // c.x, c.y, u.x, u.y, w.x, w.y
+
+    struct Config
+    {
+        MonteCarloSampling sampling = MonteCarloSampling::SOBOL;
+
+        // world region of C positions
+        T x0 = T(-2.5), y0 = T(-2.5), x1 = T(2.5), y1 = T(2.5);
+
+        // relative velocities u = vb - va and w = vc - va are drawn from
+        // [-vel_range, vel_range]^2 (zero total momentum, as in SimGrid)
+        T vel_range = T(1);
+
+        f64 confidence = 0.95;
+        f64 target_half_width = 0.01; // stop once the survival interval is this tight
+        i64 min_samples = 1024;
+        i64 max_samples = 1 << 20;
+
+        int batch_size = 256;   // samples per worker task
+        int max_in_flight = 8;  // worker tasks submitted at once
+        int histogram_bins = 32;
+        u64 seed = 1;
+    };
+
+    struct Estimate
+    {
+        i64 samples = 0;        // finished, including diverged
+        i64 diverged = 0;
+        ProportionEstimate survival;
+
+        f64 mean_iters = 0;     // mean survival iterations
+        f64 mean_iters_ci = 0;  // half width of its interval
+
+        std::vector<u32> escape_histogram; // escapes per bin of [0, max_iter)
+
+        bool converged = false; // target precision reached
+    };
+
+    ~MonteCarlo();
+
+    void start(const Env& env, const Config& cfg);
+    void cancel();
+
+    // collects finished batches and keeps the workers fed, call regularly
+    // (e.g. each frame). Returns true if the estimate changed
+    bool poll();
+
+    bool running() const            { return active; }
+    const Estimate& estimate() const { return result; }
+
+private:
+
+    struct Batch
+    {
+        std::vector<InitialConditions<T>> conditions;
+        std::vector<SimOutcome> outcomes;
+        std::future<void> done;
+    };
+
+    Config cfg;
+    std::optional<Env> env;
+    bool active = false;
+    f64 z = 1.96;
+
+    i64 submitted = 0;
+    std::vector<std::unique_ptr<Batch>> in_flight;
+
+    std::unique_ptr<SobolSequence> sobol;
+    std::mt19937_64 rng;
+
+    // running sums (Welford) of survival iterations
+    f64 iter_mean = 0, iter_m2 = 0;
+    i64 iter_n = 0;
+
+    Estimate result;
+
+    void drawSample(InitialConditions<T>& ic);
+    void submitBatches();
+    void accumulate(const Batch& batch);
+    void updateEstimate();
+    void waitAll();
+};
+
+SIM_END;
+
+#include "monte_carlo.hpp"
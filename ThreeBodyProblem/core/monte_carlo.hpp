@@ -0,0 +1,297 @@
+#include "monte_carlo.h"
+
+SIM_BEG;
+using namespace bl;
+
+/// ─────── SobolSequence ───────
+
+inline SobolSequence::SobolSequence(int dims, u64 seed) :
+    n_dims(std::clamp(dims, 1, MAX_DIMS))
+{
+    // new-joe-kuo-6.21201, dimensions 2..8: degree s, coefficients a, initial m
+    struct Primitive { int s; u32 a; u32 m[5]; };
+    static constexpr Primitive table[MAX_DIMS - 1] = {
+        { 1, 0, { 1 } },
+        { 2, 1, { 1, 3 } },
+        { 3, 1, { 1, 3, 1 } },
+        { 3, 2, { 1, 1, 1 } },
+        { 4, 1, { 1, 1, 3, 3 } },
+        { 4, 4, { 1, 3, 5, 13 } },
+        { 5, 2, { 1, 1, 5, 5, 17 } }
+    };
+
+    // first dimension is the van der Corput sequence
+    for (int k = 0; k < BITS; k++)
+        dir[0][k] = 1u << (BITS - 1 - k);
+
+    for (int d = 1; d < MAX_DIMS; d++)
+    {
+        const Primitive& p = table[d - 1];
+        u32* v = dir[d];
+        for (int k = 0; k < BITS; k++)
+        {
+            if (k < p.s)
+            {
+                v[k] = p.m[k] << (BITS - 1 - k);
+                continue;
+            }
+
+            v[k] = v[k - p.s] ^ (v[k - p.s] >> p.s);
+            for (int l = 1; l < p.s; l++)
+            {
+                if ((p.a >> (p.s - 1 - l)) & 1)
+                    v[k] ^= v[k - l];
+            }
+        }
+    }
+
+    if (seed)
+    {
+        std::mt19937_64 gen(seed);
+        for (int d = 0; d < MAX_DIMS; d++)
+            shift[d] = (u32)gen();
+    }
+}
+
+inline void SobolSequence::next(f64* out)
+{
+    constexpr f64 scale = 1.0 / 4294967296.0; // 2^-32
+
+    for (int d = 0; d < n_dims; d++)
+        out[d] = (f64)(x[d] ^ shift[d]) * scale;
+
+    // Gray code: flip the direction number of the lowest zero bit of n
+    int c = 0;
+    while ((n >> c) & 1) c++;
+    if (c < BITS)
+    {
+        for (int d = 0; d < n_dims; d++)
+            x[d] ^= dir[d][c];
+    }
+    n++;
+}
+
+/// ─────── intervals ───────
+
+inline ProportionEstimate wilsonInterval(i64 hits, i64 trials, f64 z)
+{
+    ProportionEstimate e;
+    e.hits = hits;
+    e.trials = trials;
+    if (trials <= 0)
+        return e;
+
+    const f64 n = (f64)trials;
+    const f64 p = (f64)hits / n;
+    const f64 z2 = z * z;
+    const f64 denom = 1.0 + z2 / n;
+    const f64 center = (p + z2 / (2.0 * n)) / denom;
+    const f64 half = (z / denom) * std::sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n));
+
+    e.p = p;
+    e.lo = std::max(0.0, center - half);
+    e.hi = std::min(1.0, center + half);
+    return e;
+}
+
+inline f64 confidenceZ(f64 confidence)
+{
+    // solve erf(z / sqrt(2)) = confidence by bisection
+    confidence = std::clamp(confidence, 0.5, 0.999999);
+    f64 lo = 0.0, hi = 10.0;
+    for (int i = 0; i < 64; i++)
+    {
+        f64 mid = (lo + hi) * 0.5;
+        if (std::erf(mid / std::sqrt(2.0)) < confidence) lo = mid;
+        else hi = mid;
+    }
+    return (lo + hi) * 0.5;
+}
+
+/// ─────── MonteCarlo ───────
+
+#define MonteCarloTmpl  template<class T, template<class> class StopPolicy>
+#define MonteCarloID    MonteCarlo<T, StopPolicy>
+
+MonteCarloTmpl MonteCarloID::~MonteCarlo()
+{
+    waitAll(); // tasks reference their batch buffers
+}
+
+MonteCarloTmpl void MonteCarloID::start(const Env& _env, const Config& _cfg)
+{
+    waitAll();
+
+    cfg = _cfg;
+    cfg.batch_size = std::max(1, cfg.batch_size);
+    cfg.max_in_flight = std::max(1, cfg.max_in_flight);
+    cfg.histogram_bins = std::max(1, cfg.histogram_bins);
+    env.emplace(_env);
+
+    z = confidenceZ(cfg.confidence);
+    submitted = 0;
+    iter_mean = iter_m2 = 0;
+    iter_n = 0;
+
+    result = Estimate();
+    result.escape_histogram.assign(cfg.histogram_bins, 0);
+
+    if (cfg.sampling == MonteCarloSampling::SOBOL)
+        sobol = std::make_unique<SobolSequence>(SAMPLE_DIMS, cfg.seed);
+    else
+    {
+        sobol.reset();
+        rng.seed(cfg.seed);
+    }
+
+    active = true;
+    submitBatches();
+}
+
+MonteCarloTmpl void MonteCarloID::cancel()
+{
+    waitAll();
+    active = false;
+}
+
+MonteCarloTmpl void MonteCarloID::waitAll()
+{
+    for (auto& batch : in_flight)
+        batch->done.wait();
+    in_flight.clear();
+}
+
+MonteCarloTmpl bool MonteCarloID::poll()
+{
+    if (!active)
+        return false;
+
+    bool changed = false;
+    for (size_t i = 0; i < in_flight.size();)
+    {
+        Batch& batch = *in_flight[i];
+        if (batch.done.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            i++;
+            continue;
+        }
+
+        accumulate(batch);
+        in_flight.erase(in_flight.begin() + i);
+        changed = true;
+    }
+
+    if (changed)
+        updateEstimate();
+
+    // in-flight batches still count towards the estimate after convergence
+    if (!result.converged && submitted < cfg.max_samples)
+        submitBatches();
+    else if (in_flight.empty())
+        active = false;
+
+    return changed;
+}
+
+MonteCarloTmpl void MonteCarloID::drawSample(InitialConditions<T>& ic)
+{
+    f64 r[SAMPLE_DIMS];
+    if (sobol)
+    {
+        sobol->next(r);
+    }
+    else
+    {
+        std::uniform_real_distribution<f64> uniform(0.0, 1.0);
+        for (f64& v : r) v = uniform(rng);
+    }
+
+    const T c_x = cfg.x0 + (cfg.x1 - cfg.x0) * T(r[0]);
+    const T c_y = cfg.y0 + (cfg.y1 - cfg.y0) * T(r[1]);
+    const T ux = cfg.vel_range * T(2.0 * r[2] - 1.0);
+    const T uy = cfg.vel_range * T(2.0 * r[3] - 1.0);
+    const T wx = cfg.vel_range * T(2.0 * r[4] - 1.0);
+    const T wy = cfg.vel_range * T(2.0 * r[5] - 1.0);
+
+    // same body layout and momentum balance as SimGrid
+    const T vax = -(ux + wx) / T(3);
+    const T vay = -(uy + wy) / T(3);
+
+    ic.pos[0] = Vec(T(-1), T(0));
+    ic.pos[1] = Vec(T(1), T(0));
+    ic.pos[2] = Vec(c_x, c_y);
+    ic.vel[0] = Vec(vax, vay);
+    ic.vel[1] = Vec(vax + ux, vay + uy);
+    ic.vel[2] = Vec(vax + wx, vay + wy);
+}
+
+MonteCarloTmpl void MonteCarloID::submitBatches()
+{
+    while ((int)in_flight.size() < cfg.max_in_flight && submitted < cfg.max_samples)
+    {
+        const int count = (int)std::min<i64>(cfg.batch_size, cfg.max_samples - submitted);
+
+        auto batch = std::make_unique<Batch>();
+        batch->conditions.resize(count);
+        batch->outcomes.resize(count);
+        for (InitialConditions<T>& ic : batch->conditions)
+            drawSample(ic);
+
+        Batch* b = batch.get();
+        const Env* e = &*env;
+        batch->done = submitSimTask([b, e]() {
+            evaluateBatch<T, StopPolicy>(*e, b->conditions, b->outcomes);
+        });
+
+        submitted += count;
+        in_flight.push_back(std::move(batch));
+    }
+}
+
+MonteCarloTmpl void MonteCarloID::accumulate(const Batch& batch)
+{
+    const int max_iter = env->max_iter;
+    const int bins = cfg.histogram_bins;
+
+    for (const SimOutcome& out : batch.outcomes)
+    {
+        result.samples++;
+        if (out.result.type == StopResult::DIVERGED)
+        {
+            result.diverged++;
+            continue;
+        }
+
+        const bool survived = (out.result.type == StopResult::STABLE) || (out.iters >= max_iter);
+        result.survival.trials++;
+        if (survived)
+        {
+            result.survival.hits++;
+        }
+        else
+        {
+            int bin = (int)((i64)out.iters * bins / std::max(1, max_iter));
+            result.escape_histogram[std::clamp(bin, 0, bins - 1)]++;
+        }
+
+        const f64 iters = (f64)out.iters;
+        iter_n++;
+        const f64 delta = iters - iter_mean;
+        iter_mean += delta / (f64)iter_n;
+        iter_m2 += delta * (iters - iter_mean);
+    }
+}
+
+MonteCarloTmpl void MonteCarloID::updateEstimate()
+{
+    result.survival = wilsonInterval(result.survival.hits, result.survival.trials, z);
+
+    result.mean_iters = iter_mean;
+    result.mean_iters_ci = (iter_n > 1) ? z * std::sqrt(iter_m2 / (f64)(iter_n - 1) / (f64)iter_n) : 0.0;
+
+    result.converged =
+        result.survival.trials >= cfg.min_samples &&
+        result.survival.halfWidth() <= cfg.target_half_width;
+}
+
+SIM_END;
@@ -0,0 +1,151 @@
+#pragma once
+#include "orbit_sim.h"
+#include <array>
+#include <span>
+
+SIM_BEG;
+
+using namespace bl;
+
+/// ─────── NBodySim ───────
+//
+// Sibling of Sim for N bodies with arbitrary masses (zero mass = test
+// particle, for restricted problems). Shares SimEnv, the stop policies,
+// SimKeyframes and SimPlot with the three-body Sim, which stays the
+// specialised (and SIMD-batched) path for equal-mass triples.
+//
+// Accelerations come from one of three force paths:
+//
+//   DIRECT      pair loops unrolled at compile time (N <= DIRECT_MAX)
+//   TILED       O(N^2) over TILE-sized blocks of a structure-of-arrays copy,
+//               with a branch-free inner loop that vectorizes
+//   BARNES_HUT  quadtree with monopole cells, opening angle theta. The node
+//               pool is kept across steps, so stepping doesn't allocate once
+//               the tree has reached its size. Tree forces aren't exactly
+//               antisymmetric, so the angular momentum drift check is skipped
+//
+// AUTO picks DIRECT up to DIRECT_MAX bodies, TILED up to TILED_MAX, then
+// BARNES_HUT. Integration is the same kick-drift-kick leapfrog as Sim.
+//
+// Stop policies: with N == 3 the policy's (a, b, c) interface is used, so every
+// three-body policy works unchanged (PeriodDetector still assumes equal
+// masses). Other N need the span overloads, which StopPolicy_None and
+// StopPolicy_MaxDist provide.
+
+enum class NBodyForce { AUTO, DIRECT, TILED, BARNES_HUT };
+
+inline const char* nbodyForceName(NBodyForce force)
+{
+    switch (force)
+    {
+    case NBodyForce::AUTO:       return "Auto";
+    case NBodyForce::DIRECT:     return "Direct (unrolled)";
+    case NBodyForce::TILED:      return "Tiled O(N^2)";
+    case NBodyForce::BARNES_HUT: return "Barnes-Hut";
+    }
+    return "?";
+}
+
+template<class T, int N, template<class> class StopPolicy = StopPolicy_MaxDist>
+class NBodySim
+{
+    #define NBodySimTmpl  template<class T, int N, template<class> class StopPolicy>
+    #define NBodySimID    NBodySim<T, N, StopPolicy>
+
+    static_assert(N >= 2, "NBodySim needs at least two bodies");
+
+    static constexpr bool policy_has_span = requires(StopPolicy<T> rule, std::span<const Particle<T>> bodies) {
+        rule.stability(0, bodies);
+    };
+    static_assert(N == 3 || policy_has_span, "stop policy has no span (N-body) overloads");
+
+public:
+
+    using Env = SimEnv<T>;
+    using Vec = Vec2<T>;
+
+    static constexpr int DIRECT_MAX = 8;
+    static constexpr int TILED_MAX = 512;
+    static constexpr int TILE = 64;
+
+    static constexpr int bodyCount() { return N; }
+
+    // pos/vel hold N entries, mass empty = unit masses
+    void setup(const Env& env, std::span<const Vec> pos, std::span<const Vec> vel, std::span<const T> mass = {});
+
+    // same starting state as a three-body sim (unit masses)
+    template<class U> requires (N == 3)
+    void setup(const Env& env, const Sim<U, StopPolicy>& src);
+
+    void       setForce(NBodyForce f) { force = f; }
+    NBodyForce activeForce() const;
+    void       setTheta(T t)          { theta = t; } // Barnes-Hut opening angle
+
+    void progress(const Env& env); // also feeds StopPolicy::observe() if the policy has one
+    void regress(const Env& env);
+    StopResult stability() const;
+    bool       diverged() const;
+    int        curIter() const { return iter; }
+
+    T energy() const; // valid after setup()/progress()
+    T angularMomentum() const;
+
+    Vec                particle(int i) const { return p[i]; }
+    const Particle<T>& body(int i) const     { return p[i]; }
+    T                  mass(int i) const     { return m[i]; }
+    std::span<const Particle<T>> bodies() const { return p; }
+
+private:
+
+    std::array<Particle<T>, N> p{};
+    std::array<T, N> m{};
+    int iter = 0;
+
+    NBodyForce force = NBodyForce::AUTO;
+    T theta{ T(0.5) };
+
+    // conservation tracking: pot is a by-product of the force paths
+    T pot{};
+    T energy0{}, energy_err_max{};
+    T momentum0{}, momentum_err_max{};
+    bool check_energy = false, check_momentum = false;
+
+    [[no_unique_address]] StopPolicy<T> unstable_rule;
+
+    // Barnes-Hut quadtree, node 0 is the root
+    struct Node
+    {
+        T cx, cy, half;     // cell centre and half-width
+        T mx, my, mass;     // mass-weighted position sum, then centre of mass
+        int child[4];       // -1 = none
+        int first;          // leaf: first body (linked through next_body), -1 = internal
+        int count;
+    };
+    static constexpr int MAX_TREE_DEPTH = 32; // deeper bodies share a leaf
+
+    std::vector<Node> nodes;
+    std::array<int, N> next_body{};
+
+    // TILED structure-of-arrays scratch
+    alignas(64) std::array<T, N> sx{}, sy{}, sm{}, sax{}, say{}, sphi{};
+
+    void computeAccels(const Env& env);
+    void accelsDirect(const T G, const T soft2);
+    void accelsTiled(const T G, const T soft2);
+    void accelsBarnesHut(const T G, const T soft2);
+    void buildTree();
+    int  childFor(int node, int body); // quadrant of node holding body (created on demand)
+    void insert(int node, int body, int depth);
+
+    template<int I, int J> void pairwise(const T G, const T soft2);
+    template<int I> void pairsFrom(const T G, const T soft2);
+
+    void leapfrog(const Env& env, const T dt);
+    void begin(const Env& env);
+
+    template<class> friend class SimKeyframes;
+};
+
+SIM_END;
+
+#include "nbody_sim.hpp"
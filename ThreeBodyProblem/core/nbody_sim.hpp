@@ -0,0 +1,461 @@
+#include "sim_types.h"
+#include <utility>
+
+SIM_BEG;
+using namespace bl;
+
+/// ─────── setup ───────
+
+NBodySimTmpl void NBodySimID::setup(const Env& env, std::span<const Vec> pos, std::span<const Vec> vel, std::span<const T> mass)
+{
+    for (int i = 0; i < N; i++)
+    {
+        p[i].set(pos[i]);
+        p[i].vx = vel[i].x; p[i].vy = vel[i].y;
+        m[i] = mass.empty() ? T(1) : mass[i];
+    }
+
+    begin(env);
+}
+
+NBodySimTmpl template<class U> requires (N == 3)
+void NBodySimID::setup(const Env& env, const Sim<U, StopPolicy>& src)
+{
+    const Particle<U>* from[3] = { &src.bodyA(), &src.bodyB(), &src.bodyC() };
+    for (int i = 0; i < 3; i++)
+    {
+        p[i].x = T(from[i]->x);   p[i].y = T(from[i]->y);
+        p[i].vx = T(from[i]->vx); p[i].vy = T(from[i]->vy);
+        m[i] = T(1);
+    }
+
+    begin(env);
+}
+
+NBodySimTmpl NBodyForce NBodySimID::activeForce() const
+{
+    switch (force)
+    {
+    case NBodyForce::DIRECT:     return (N <= DIRECT_MAX) ? NBodyForce::DIRECT : NBodyForce::TILED;
+    case NBodyForce::TILED:      return NBodyForce::TILED;
+    case NBodyForce::BARNES_HUT: return NBodyForce::BARNES_HUT;
+    default:
+        if (N <= DIRECT_MAX) return NBodyForce::DIRECT;
+        if (N <= TILED_MAX)  return NBodyForce::TILED;
+        return NBodyForce::BARNES_HUT;
+    }
+}
+
+/// ─────── conservation ───────
+
+NBodySimTmpl T NBodySimID::energy() const
+{
+    T kinetic{};
+    for (int i = 0; i < N; i++)
+        kinetic += m[i] * (p[i].vx * p[i].vx + p[i].vy * p[i].vy);
+    return T(0.5) * kinetic + pot;
+}
+
+NBodySimTmpl T NBodySimID::angularMomentum() const
+{
+    T l{};
+    for (int i = 0; i < N; i++)
+        l += m[i] * (p[i].x * p[i].vy - p[i].y * p[i].vx);
+    return l;
+}
+
+NBodySimTmpl bool NBodySimID::diverged() const
+{
+    using std::abs;
+    if (check_energy && abs(energy() - energy0) > energy_err_max)
+        return true;
+
+    return check_momentum && activeForce() != NBodyForce::BARNES_HUT &&
+           abs(angularMomentum() - momentum0) > momentum_err_max;
+}
+
+NBodySimTmpl StopResult NBodySimID::stability() const
+{
+    if (diverged())
+        return StopResult(StopResult::DIVERGED, iter);
+
+    if constexpr (N == 3)
+        return unstable_rule.stability(iter, p[0], p[1], p[2]);
+    else
+        return unstable_rule.stability(iter, bodies());
+}
+
+NBodySimTmpl void NBodySimID::begin(const Env& env)
+{
+    iter = 0;
+
+    // reference values for drift monitoring
+    computeAccels(env);
+    energy0 = energy();
+    momentum0 = angularMomentum();
+
+    using std::abs;
+    using std::sqrt;
+    const T kinetic = energy0 - pot;
+    const T energy_scale = abs(kinetic) + abs(pot);
+
+    T total_mass{};
+    for (int i = 0; i < N; i++)
+        total_mass += m[i];
+
+    // m|r||v| per body, with a circular-orbit speed floor so bodies at rest still get a scale
+    const T v_floor = total_mass > T(0) ? sqrt(abs(pot) / total_mass) : T(0);
+    T momentum_scale{};
+    for (int i = 0; i < N; i++)
+        momentum_scale += m[i] * sqrt(p[i].mag2()) * (sqrt(p[i].vx * p[i].vx + p[i].vy * p[i].vy) + v_floor);
+
+    energy_err_max = env.energy_tolerance * energy_scale;
+    momentum_err_max = env.momentum_tolerance * momentum_scale;
+    check_energy = env.energy_tolerance > T(0);
+    check_momentum = env.momentum_tolerance > T(0);
+
+    if constexpr (N == 3)
+        unstable_rule.init(&env, p[0], p[1], p[2]);
+    else
+        unstable_rule.init(&env, bodies());
+}
+
+/// ─────── forces ───────
+
+NBodySimTmpl void NBodySimID::computeAccels(const Env& env)
+{
+    const NBodyForce f = activeForce();
+
+    if constexpr (N <= DIRECT_MAX)
+    {
+        if (f == NBodyForce::DIRECT)
+        {
+            accelsDirect(env.G, env.soft2);
+            return;
+        }
+    }
+
+    if (f == NBodyForce::BARNES_HUT)
+        accelsBarnesHut(env.G, env.soft2);
+    else
+        accelsTiled(env.G, env.soft2);
+}
+
+NBodySimTmpl template<int I, int J> void NBodySimID::pairwise(const T G, const T soft2)
+{
+    using std::sqrt;
+    Particle<T>& a = p[I];
+    Particle<T>& b = p[J];
+
+    const T rx = b.x - a.x;
+    const T ry = b.y - a.y;
+    const T r2 = rx * rx + ry * ry + soft2;
+    const T inv_r = T(1) / sqrt(r2);
+    const T inv_r3 = inv_r * inv_r * inv_r;
+    const T scale = G * inv_r3;
+    const T fx = scale * rx;
+    const T fy = scale * ry;
+    a.ax += m[J] * fx; a.ay += m[J] * fy;
+    b.ax -= m[I] * fx; b.ay -= m[I] * fy;
+    pot -= G * m[I] * m[J] * inv_r;
+}
+
+NBodySimTmpl template<int I> void NBodySimID::pairsFrom(const T G, const T soft2)
+{
+    [&]<int... K>(std::integer_sequence<int, K...>) {
+        (pairwise<I, I + 1 + K>(G, soft2), ...);
+    }(std::make_integer_sequence<int, N - 1 - I>{});
+}
+
+NBodySimTmpl void NBodySimID::accelsDirect(const T G, const T soft2)
+{
+    for (Particle<T>& b : p)
+        b.ax = b.ay = T(0);
+    pot = T(0);
+
+    // every pair (I < J) expanded at compile time
+    [&]<int... I>(std::integer_sequence<int, I...>) {
+        (pairsFrom<I>(G, soft2), ...);
+    }(std::make_integer_sequence<int, N>{});
+}
+
+NBodySimTmpl void NBodySimID::accelsTiled(const T G, const T soft2)
+{
+    using std::sqrt;
+    for (int i = 0; i < N; i++)
+    {
+        sx[i] = p[i].x; sy[i] = p[i].y; sm[i] = m[i];
+        sax[i] = say[i] = sphi[i] = T(0);
+    }
+
+    // sources (xj, yj, mj) acting on targets [i0, i1). The loop runs over
+    // targets (independent lanes, no reduction), so it vectorizes without -ffast-math
+    auto accumulate = [&](T xj, T yj, T mj, int i0, int i1)
+    {
+        for (int i = i0; i < i1; i++)
+        {
+            const T rx = xj - sx[i];
+            const T ry = yj - sy[i];
+            const T inv_r = T(1) / sqrt(rx * rx + ry * ry + soft2);
+            const T m_inv_r = mj * inv_r;
+            const T s = m_inv_r * inv_r * inv_r;
+            sax[i] += s * rx;
+            say[i] += s * ry;
+            sphi[i] += m_inv_r;
+        }
+    };
+
+    // full (non-symmetric) sum, one TILE of targets at a time so their
+    // accumulators stay in L1 while every source streams past
+    for (int i0 = 0; i0 < N; i0 += TILE)
+    {
+        const int i1 = std::min(i0 + TILE, N);
+        for (int j = 0; j < N; j++)
+        {
+            if (j >= i0 && j < i1)
+            {
+                // skip the self-pair
+                accumulate(sx[j], sy[j], sm[j], i0, j);
+                accumulate(sx[j], sy[j], sm[j], j + 1, i1);
+            }
+            else
+            {
+                accumulate(sx[j], sy[j], sm[j], i0, i1);
+            }
+        }
+    }
+
+    T phi_sum{};
+    for (int i = 0; i < N; i++)
+    {
+        p[i].ax = G * sax[i];
+        p[i].ay = G * say[i];
+        phi_sum += sm[i] * sphi[i];
+    }
+    pot = -T(0.5) * G * phi_sum; // every pair counted twice
+}
+
+/// ─────── Barnes-Hut ───────
+
+NBodySimTmpl int NBodySimID::childFor(int node, int body)
+{
+    const Node& n = nodes[node];
+    const int q = (p[body].x >= n.cx ? 1 : 0) | (p[body].y >= n.cy ? 2 : 0);
+    if (n.child[q] >= 0)
+        return n.child[q];
+
+    const T h = n.half * T(0.5);
+    Node c{};
+    c.cx = n.cx + ((q & 1) ? h : -h);
+    c.cy = n.cy + ((q & 2) ? h : -h);
+    c.half = h;
+    c.child[0] = c.child[1] = c.child[2] = c.child[3] = -1;
+    c.first = -1;
+
+    const int index = (int)nodes.size();
+    nodes.push_back(c); // invalidates n
+    nodes[node].child[q] = index;
+    return index;
+}
+
+NBodySimTmpl void NBodySimID::insert(int node, int body, int depth)
+{
+    while (true)
+    {
+        if (nodes[node].count == 0)
+        {
+            nodes[node].first = body;
+            nodes[node].count = 1;
+            next_body[body] = -1;
+            return;
+        }
+
+        if (nodes[node].first >= 0)
+        {
+            if (depth >= MAX_TREE_DEPTH)
+            {
+                // (near-)coincident bodies: share the leaf
+                next_body[body] = nodes[node].first;
+                nodes[node].first = body;
+                nodes[node].count++;
+                return;
+            }
+
+            // split the leaf, its single resident moves one level down
+            const int resident = nodes[node].first;
+            nodes[node].first = -1;
+            insert(childFor(node, resident), resident, depth + 1);
+        }
+
+        nodes[node].count++;
+        node = childFor(node, body);
+        depth++;
+    }
+}
+
+NBodySimTmpl void NBodySimID::buildTree()
+{
+    T x0 = p[0].x, x1 = p[0].x, y0 = p[0].y, y1 = p[0].y;
+    for (int i = 1; i < N; i++)
+    {
+        x0 = std::min(x0, p[i].x); x1 = std::max(x1, p[i].x);
+        y0 = std::min(y0, p[i].y); y1 = std::max(y1, p[i].y);
+    }
+
+    // keeps capacity, so the pool stops allocating once it has grown to size
+    nodes.clear();
+
+    Node root{};
+    root.cx = (x0 + x1) * T(0.5);
+    root.cy = (y0 + y1) * T(0.5);
+    root.half = std::max(x1 - x0, y1 - y0) * T(0.5) * T(1.0001) + T(1e-9);
+    root.child[0] = root.child[1] = root.child[2] = root.child[3] = -1;
+    root.first = -1;
+    nodes.push_back(root);
+
+    for (int i = 0; i < N; i++)
+        insert(0, i, 0);
+
+    // children always come after their parent, so a reverse pass is bottom-up
+    for (int k = (int)nodes.size() - 1; k >= 0; k--)
+    {
+        Node& n = nodes[k];
+        T mass{}, mx{}, my{};
+        if (n.first >= 0)
+        {
+            for (int b = n.first; b >= 0; b = next_body[b])
+            {
+                mass += m[b];
+                mx += m[b] * p[b].x;
+                my += m[b] * p[b].y;
+            }
+        }
+        else
+        {
+            for (int c : n.child)
+            {
+                if (c < 0) continue;
+                const Node& child = nodes[c];
+                mass += child.mass;
+                mx += child.mass * child.mx;
+                my += child.mass * child.my;
+            }
+        }
+
+        n.mass = mass;
+        n.mx = mass > T(0) ? mx / mass : n.cx;
+        n.my = mass > T(0) ? my / mass : n.cy;
+    }
+}
+
+NBodySimTmpl void NBodySimID::accelsBarnesHut(const T G, const T soft2)
+{
+    using std::sqrt;
+    buildTree();
+
+    const T theta2 = theta * theta;
+    T phi_sum{};
+
+    int stack[3 * MAX_TREE_DEPTH + 4];
+
+    for (int i = 0; i < N; i++)
+    {
+        const T xi = p[i].x, yi = p[i].y;
+        T ax{}, ay{}, phi{};
+
+        auto attract = [&](T px, T py, T mass)
+        {
+            const T rx = px - xi;
+            const T ry = py - yi;
+            const T inv_r = T(1) / sqrt(rx * rx + ry * ry + soft2);
+            const T m_inv_r = mass * inv_r;
+            const T s = m_inv_r * inv_r * inv_r;
+            ax += s * rx;
+            ay += s * ry;
+            phi += m_inv_r;
+        };
+
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node& n = nodes[stack[--top]];
+            if (n.mass <= T(0)) continue;
+
+            if (n.first >= 0)
+            {
+                for (int b = n.first; b >= 0; b = next_body[b])
+                    if (b != i) attract(p[b].x, p[b].y, m[b]);
+                continue;
+            }
+
+            // monopole if the cell looks small enough and doesn't contain body i
+            const T rx = n.mx - xi;
+            const T ry = n.my - yi;
+            const T size = n.half * T(2);
+            const bool inside = std::abs(xi - n.cx) <= n.half && std::abs(yi - n.cy) <= n.half;
+            if (!inside && size * size < theta2 * (rx * rx + ry * ry))
+            {
+                attract(n.mx, n.my, n.mass);
+                continue;
+            }
+
+            for (int c : n.child)
+                if (c >= 0) stack[top++] = c;
+        }
+
+        p[i].ax = G * ax;
+        p[i].ay = G * ay;
+        phi_sum += m[i] * phi;
+    }
+
+    pot = -T(0.5) * G * phi_sum;
+}
+
+/// ─────── integration ───────
+
+NBodySimTmpl void NBodySimID::leapfrog(const Env& env, const T dt)
+{
+    const T half_dt = T(0.5) * dt;
+
+    // accelerations are still those of the current positions (from begin() or
+    // the previous step), so each step costs one force evaluation
+    for (Particle<T>& b : p)
+    {
+        b.vx += b.ax * half_dt; b.vy += b.ay * half_dt;
+        b.x += b.vx * dt;       b.y += b.vy * dt;
+    }
+
+    computeAccels(env);
+
+    for (Particle<T>& b : p)
+    {
+        b.vx += b.ax * half_dt; b.vy += b.ay * half_dt;
+    }
+}
+
+NBodySimTmpl void NBodySimID::progress(const Env& env)
+{
+    leapfrog(env, env.dt);
+    iter++;
+
+    if constexpr (N == 3)
+    {
+        if constexpr (requires { unstable_rule.observe(iter, p[0], p[1], p[2]); })
+            unstable_rule.observe(iter, p[0], p[1], p[2]);
+    }
+    else
+    {
+        if constexpr (requires { unstable_rule.observe(iter, bodies()); })
+            unstable_rule.observe(iter, bodies());
+    }
+}
+
+NBodySimTmpl void NBodySimID::regress(const Env& env)
+{
+    // kick-drift-kick with -dt undoes a step (exactly only for the symmetric force paths)
+    leapfrog(env, -env.dt);
+    iter--;
+}
+
+SIM_END;
@@ -0,0 +1,577 @@
+#pragma once
+#include "sim_types.h"
+#include "cpu_dispatch.h"
+#include <numbers>
+#include <span>
+#include <thread>
+
+SIM_BEG;
+
+using namespace bl;
+
+
+
+struct StopResult
+{
+    enum StopResultType
+    {
+        INVALID=1,      // sim exclude from possible results (e.g. non-periodic orbit),
+        UNSTABLE=2,     // sim could be unstable, but still included as a "near-stable" result
+        UNDETERMINED=4, // sim running, not known if stable or not
+        INCONCLUSIVE=8, // sim finished, but still not known if stable or not
+        STABLE=16,
+        DIVERGED=32,    // sim numerically invalid (energy/angular momentum drifted past tolerance)
+        RULED_OUT=64,   // excluded by the analytic pre-filter, never integrated
+
+        ABORT_MASK = INVALID | STABLE | UNSTABLE | DIVERGED | RULED_OUT,
+        EXCLUDE_MASK = INVALID | DIVERGED | RULED_OUT
+    };
+
+    static const char* typeName(StopResultType type)
+    {
+        switch (type)
+        {
+        case INVALID:      return "Invalid";
+        case UNSTABLE:     return "Unstable";
+        case UNDETERMINED: return "Undetermined";
+        case INCONCLUSIVE: return "Inconclusive";
+        case STABLE:       return "Stable";
+        case DIVERGED:     return "Diverged";
+        case RULED_OUT:    return "Ruled out";
+        default:           return "?";
+        }
+    }
+
+    StopResultType type;
+    f64 iter;
+
+    StopResult(StopResultType _type= INVALID, f64 _stability=-1.0) :
+        type(_type), iter(_stability)
+    { }
+
+    // never allowed to win a ranking (isBetterResult() only compares included results)
+    bool excluded() const { return (int)type & (int)EXCLUDE_MASK; }
+};
+
+template<class T>
+struct Particle : public Vec2<T> 
+{
+    T vx, vy, ax, ay;
+};
+
+template<class T>
+struct SimEnv
+{
+    static constexpr int max_dist = 10;// 5; // max dist from origin to be considered unstable
+
+    int escape_freq = 10; // how often we check for escape
+    int max_iter;
+    T max_vel, dt;
+    T G{ 1 };
+    T soft2{ T(0.0002) };
+
+    // stability params
+    T pos_tolerance;
+    T vel_tolerance;
+
+    // conservation drift (relative to the initial energy/angular momentum scale)
+    // beyond which a sim is aborted as StopResult::DIVERGED, <= 0 disables that check
+    T energy_tolerance{ T(0.1) };
+    T momentum_tolerance{ T(1e-6) };
+
+    // analytic pre-filter, applied by SimGrid::run() before any integration
+    // Both are off by default. prefilter_unbound is lossy: E >= 0 sims do escape
+    // eventually, but their survival time is discarded (it may still reach max_iter)
+    bool prefilter_unbound = false;      // E >= 0 can't stay bound: ruled out
+    bool prefilter_hierarchical = false; // Mardling-Aarseth stable triples: verified and fast-tracked (survival policies)
+
+    SimEnv(T _G, T _vel, int _iters, T _dt)
+    {
+        G = _G;
+        max_iter = _iters;
+        max_vel = _vel;
+        dt = _dt;
+
+        pos_tolerance = T(0.02);
+        vel_tolerance = max_vel / T(10);
+    }
+
+    // same configuration in another float type (e.g. f64 -> ddouble)
+    template<class U>
+    explicit SimEnv(const SimEnv<U>& r) :
+        escape_freq(r.escape_freq), max_iter(r.max_iter),
+        max_vel(T(r.max_vel)), dt(T(r.dt)), G(T(r.G)), soft2(T(r.soft2)),
+        pos_tolerance(T(r.pos_tolerance)), vel_tolerance(T(r.vel_tolerance)),
+        energy_tolerance(T(r.energy_tolerance)), momentum_tolerance(T(r.momentum_tolerance)),
+        prefilter_unbound(r.prefilter_unbound), prefilter_hierarchical(r.prefilter_hierarchical)
+    {}
+};
+
+// ranks_by_survival: the result is "longest time before abort", so a run with a
+// large max_iter also answers every smaller max_iter (clamp the escape iteration)
+//
+// The span overloads serve NBodySim with N != 3 bodies.
+
+template<class T> 
+struct StopPolicy_None
+{
+    static constexpr bool ranks_by_survival = true;
+
+    void init(const SimEnv<T>*, const Particle<T>&, const Particle<T>&, const Particle<T>&) 
+    {}
+
+    StopResult stability(int iter, const Particle<T>&, const Particle<T>&, const Particle<T>&) const
+    {
+        return StopResult::UNDETERMINED;
+    }
+
+    void init(const SimEnv<T>*, std::span<const Particle<T>>)
+    {}
+
+    StopResult stability(int iter, std::span<const Particle<T>>) const
+    {
+        return StopResult::UNDETERMINED;
+    }
+
+    static bool isBetterResult(StopResult result, StopResult other)
+    {
+        return result.iter > other.iter;
+    }
+};
+
+template<class T>
+struct StopPolicy_MaxDist
+{
+    static constexpr bool ranks_by_survival = true;
+
+    int max_iter;
+    void init(const SimEnv<T>* env, const Particle<T>&, const Particle<T>&, const Particle<T>&) 
+    {
+        max_iter = env->max_iter;
+    }
+
+    StopResult stability(int iter, const Particle<T>& a, const Particle<T>& b, const Particle<T>& c) const
+    {
+        constexpr T max_mag2 = SimEnv<T>::max_dist * SimEnv<T>::max_dist;
+        if (a.mag2() > max_mag2) return StopResult(StopResult::UNSTABLE, iter);
+        if (b.mag2() > max_mag2) return StopResult(StopResult::UNSTABLE, iter);
+        if (c.mag2() > max_mag2) return StopResult(StopResult::UNSTABLE, iter);
+        if (iter >= max_iter) return StopResult(StopResult::UNSTABLE, iter);
+        return StopResult(StopResult::UNDETERMINED, iter);
+    }
+
+    void init(const SimEnv<T>* env, std::span<const Particle<T>>)
+    {
+        max_iter = env->max_iter;
+    }
+
+    StopResult stability(int iter, std::span<const Particle<T>> bodies) const
+    {
+        constexpr T max_mag2 = SimEnv<T>::max_dist * SimEnv<T>::max_dist;
+        for (const Particle<T>& p : bodies)
+            if (p.mag2() > max_mag2) return StopResult(StopResult::UNSTABLE, iter);
+        if (iter >= max_iter) return StopResult(StopResult::UNSTABLE, iter);
+        return StopResult(StopResult::UNDETERMINED, iter);
+    }
+
+    static bool isBetterResult(StopResult result, StopResult other)
+    {
+        return result.iter > other.iter;
+    }
+};
+
+// Recurrence detector on a Poincare section: the section is body A crossing
+// the centre-of-mass line y = com.y upwards. Each crossing's state (relative to
+// the centre of mass, interpolated onto the section) is quantised and hashed
+// into a small open-addressed table, so a recurrence with any earlier crossing
+// is found in O(1) - including orbits that only settle after a transient.
+template<class T>
+class PeriodDetector
+{
+public:
+
+    static constexpr int DIMS = 7;        // a.x, a.vx, a.vy, b.x, b.y, b.vx, b.vy (c follows from the COM)
+    static constexpr int TABLE_SIZE = 16; // slots (power of 2), oldest crossings get evicted
+    static constexpr int PROBE_LEN = 4;
+
+    void init(T pos_quantum, T vel_quantum, int min_period)
+    {
+        inv_quantum[0] = T(1) / pos_quantum;
+        inv_quantum[1] = inv_quantum[2] = T(1) / vel_quantum;
+        inv_quantum[3] = inv_quantum[4] = T(1) / pos_quantum;
+        inv_quantum[5] = inv_quantum[6] = T(1) / vel_quantum;
+        this->min_period = min_period;
+        for (Slot& slot : table) slot.iter = -1;
+        has_prev = false;
+        period = 0;
+        crossings = 0;
+    }
+
+    // feed every step, returns true once a recurrence has been found
+    bool observe(int iter, const Particle<T>& a, const Particle<T>& b, const Particle<T>& c);
+
+    int periodIters() const { return period; }     // 0 until found
+    int periodStart() const { return period_beg; } // iteration of the earlier matching crossing
+    int crossingCount() const { return crossings; }
+
+private:
+
+    struct Slot
+    {
+        i32 iter;
+        u32 cell;
+        i16 q[DIMS];
+    };
+
+    Slot table[TABLE_SIZE];
+    T inv_quantum[DIMS];
+    T prev[DIMS];
+    T prev_y{};
+    bool has_prev = false;
+
+    int min_period = 0;
+    int period = 0;
+    int period_beg = 0;
+    int crossings = 0;
+
+    static u32 cellKey(int q0, int q2) { return ((u32)q0 * 0x9E3779B1u) ^ ((u32)q2 * 0x85EBCA77u); }
+    bool crossing(int iter, const i16 (&q)[DIMS]);
+};
+
+template<class T>
+struct StopPolicy_Periodic
+{
+    static constexpr bool ranks_by_survival = false;
+
+    Particle<T> beg_a, beg_b, beg_c;
+    T vel_floor2;
+
+    PeriodDetector<T> detector;
+
+    int max_iter;
+    void init(const SimEnv<T>* env, const Particle<T>& a, const Particle<T>& b, const Particle<T>& c)
+    {
+        max_iter = env->max_iter;
+        beg_a = a;
+        beg_b = b;
+        beg_c = c;
+
+        const T vel_quantum = env->vel_tolerance > T(0) ? env->vel_tolerance : env->pos_tolerance;
+        vel_floor2 = vel_quantum * vel_quantum;
+        detector.init(env->pos_tolerance, vel_quantum, 120);
+    }
+
+    void observe(int iter, const Particle<T>& a, const Particle<T>& b, const Particle<T>& c)
+    {
+        detector.observe(iter, a, b, c);
+    }
+
+    // fallback for orbits that never cross the section (e.g. collinear motion)
+    bool similar(const Particle<T>& beg, const Particle<T>& now) const
+    {
+        constexpr T max_dist2 = bl::sq(0.01);
+
+        const Vec2<T> delta_pos(now.x - beg.x, now.y - beg.y);
+        if (delta_pos.mag2() > max_dist2) return false;
+
+        // within 10% of the starting speed (no division, so zero velocities are fine)
+        const T dvx = now.vx - beg.vx, dvy = now.vy - beg.vy;
+        const T beg_v2 = beg.vx * beg.vx + beg.vy * beg.vy;
+        if (dvx * dvx + dvy * dvy > T(0.01) * std::max(beg_v2, vel_floor2)) return false;
+
+        return true;
+    }
+
+    StopResult stability(int iter, const Particle<T>& a, const Particle<T>& b, const Particle<T>& c) const
+    {
+        if (iter < 120)
+            return StopResult(StopResult::UNDETERMINED, iter);
+
+        constexpr T max_mag2 = SimEnv<T>::max_dist * SimEnv<T>::max_dist;
+        if (a.mag2() > max_mag2) return StopResult(StopResult::INVALID, iter);
+        if (b.mag2() > max_mag2) return StopResult(StopResult::INVALID, iter);
+        if (c.mag2() > max_mag2) return StopResult(StopResult::INVALID, iter);
+
+        // STABLE results report the period (in iterations)
+        if (detector.periodIters() > 0)
+            return StopResult(StopResult::STABLE, detector.periodIters());
+
+        if (similar(beg_a, a) &&
+            similar(beg_b, b) &&
+            similar(beg_c, c))
+        {
+            return StopResult(StopResult::STABLE, iter);
+        }
+
+        if (iter >= max_iter) return StopResult(StopResult::INVALID, iter);
+        return StopResult(StopResult::UNDETERMINED, iter);
+    }
+
+    static bool isBetterResult(StopResult result, StopResult other)
+    {
+        if (result.type == other.type)
+        {
+            if (result.type == StopResult::STABLE)
+                return (result.iter < other.iter); // For now, favour smaller loops as they're cleaner/simpler
+            else
+                return (result.type > other.type);
+        }
+        
+        return (result.type > other.type);
+    }
+};
+
+/// ─────── analytic pre-filter ───────
+//
+// Classifies a starting state before integration:
+//
+//   RULED_OUT    total energy E >= 0: the moment of inertia grows without
+//                bound (Lagrange-Jacobi), so no bound orbit is possible
+//   FAST_TRACK   hierarchical triple (closest pair bound, third body on a
+//                bound outer orbit) that satisfies the Mardling-Aarseth (2001)
+//                stability bound, with every body's apocentre inside
+//                SimEnv::max_dist. The inner orbit must span many steps and
+//                keep its pericentre well outside the softening length. Only
+//                used by policies that rank by survival. A candidate, not a
+//                verdict: SimGrid::run() integrates it, and only a candidate
+//                that lasts the whole run spares the rest of the grid
+//
+// Bodies have unit mass. RULED_OUT is lossy for survival policies: the
+// escape time of an E >= 0 sim is discarded (see SimEnv::prefilter_unbound).
+
+enum class PrefilterClass { INTEGRATE, RULED_OUT, FAST_TRACK };
+
+template<class T>
+PrefilterClass prefilterClassify(const SimEnv<T>& env, const Particle<T>& a, const Particle<T>& b, const Particle<T>& c, T energy, bool survival);
+
+template<class T, template<class> class StopPolicy>
+struct SimKernel;
+
+// Periodic snapshots of a sim (recorded by SimPlot::plot). Seeking restores the
+// nearest earlier keyframe and integrates forward, so reaching any iteration
+// costs at most `interval` steps.
+template<class SimT>
+class SimKeyframes
+{
+    // copying a Sim restarts its iteration count, so keep it alongside
+    struct Keyframe { SimT sim; int iter; };
+
+    std::vector<Keyframe> keys;
+    int interval = 500;
+    int length = 0;
+
+public:
+
+    void clear()                    { keys.clear(); length = 0; }
+    void setInterval(int iters)     { interval = std::max(1, iters); }
+    int  getInterval() const        { return interval; }
+    int  lastIter() const           { return length; } // last recorded iteration
+    bool empty() const              { return keys.empty(); }
+
+    void record(const SimT& sim)    { keys.push_back({ sim, sim.curIter() }); }
+    void finish(int iters)          { length = iters; }
+
+    // restores the keyframe exactly at iter (false if iter isn't on the keyframe grid)
+    bool restore(int iter, SimT& out) const;
+
+    // restore the state at iter (clamped to recorded range) into out
+    template<class Env> void seek(const Env& env, int iter, SimT& out) const;
+};
+
+template<class T, template<class> class StopPolicy = StopPolicy_MaxDist>
+class Sim
+{
+    #define SimTmpl  template<class T, template<class> class StopPolicy>
+    #define SimID    Sim<T, StopPolicy>
+
+    using Env = SimEnv<T>;
+    using Vec = Vec2<T>;
+
+    Particle<T> a, b, c;
+    int iter = 0;
+
+    // conservation tracking: pot is a by-product of compute_accels()
+    T pot{};
+    T energy0{}, energy_err_max{};
+    T momentum0{}, momentum_err_max{};
+    bool check_energy = false, check_momentum = false;
+
+    [[no_unique_address]] StopPolicy<T> unstable_rule;
+
+    T    pairwise_gravity(Particle<T>& p, Particle<T>& q, const T G, const T soft2);
+    void compute_accels(Particle<T>& a, Particle<T>& b, Particle<T>& c, const T G, const T soft2);
+    void leapfrog(const Env& env, const T dt);
+    void begin(const Env& env); // reset iter, drift references and stop policy
+
+    friend struct SimKernel<T, StopPolicy>;
+    template<class> friend class SimKeyframes;
+
+public:
+
+    Sim() = default;
+
+    // copies restart the iteration count (SimKeyframes keeps it alongside)
+    Sim(const Sim<T, StopPolicy>& r) : a(r.a), b(r.b), c(r.c), pot(r.pot),
+        energy0(r.energy0), energy_err_max(r.energy_err_max),
+        momentum0(r.momentum0), momentum_err_max(r.momentum_err_max),
+        check_energy(r.check_energy), check_momentum(r.check_momentum), unstable_rule(r.unstable_rule)
+    {}
+    Sim& operator=(const Sim<T, StopPolicy>& r)
+    {
+        a = r.a; b = r.b; c = r.c;
+        iter = 0;
+        pot = r.pot;
+        energy0 = r.energy0; energy_err_max = r.energy_err_max;
+        momentum0 = r.momentum0; momentum_err_max = r.momentum_err_max;
+        check_energy = r.check_energy; check_momentum = r.check_momentum;
+        unstable_rule = r.unstable_rule;
+        return *this;
+    }
+    bool operator ==(const Sim<T, StopPolicy>& r) const {
+        return (a == r.a) && (b == r.b) && (c == r.c);
+    }
+
+    void setup(const Env& env, Vec pos, Vec vel_a, Vec vel_b, Vec vel_c);
+
+    // arbitrary starting positions (a, b, c)
+    void setup(const Env& env, const Vec (&pos)[3], const Vec (&vel)[3]);
+
+    // starts from src's current state (any float type, e.g. f64 -> ddouble)
+    template<class U> void setup(const Env& env, const Sim<U, StopPolicy>& src);
+
+    void progress(const Env& env); // also feeds StopPolicy::observe() if the policy has one
+    void regress(const Env& env); // steps back one iteration (leapfrog is time-reversible)
+    StopResult stability() const;
+    bool       diverged() const;
+    bool       escaped(int iter_lim)  { return iter >= (iter_lim - Env::escape_freq); }
+    int        curIter() const        { return iter; }
+
+    T energy() const; // valid after setup()/progress()
+    T angularMomentum() const;
+
+    Vec particleA() const { return a; }
+    Vec particleB() const { return b; }
+    Vec particleC() const { return c; }
+
+    // same accessors as NBodySim
+    static constexpr int bodyCount() { return 3; }
+    Vec particle(int i) const { return i == 0 ? a : (i == 1 ? b : c); }
+
+    // full state (position + velocity)
+    const Particle<T>& bodyA() const { return a; }
+    const Particle<T>& bodyB() const { return b; }
+    const Particle<T>& bodyC() const { return c; }
+};
+
+// Lane-batched integrator: up to LANES sims are stepped in lockstep from a
+// structure-of-arrays copy, so the per-lane loops vectorize to the widest ISA
+// of the variant. Arithmetic matches Sim::progress() operation for operation.
+template<class T, template<class> class StopPolicy>
+struct SimKernel
+{
+    using SimT = Sim<T, StopPolicy>;
+    using Env = SimEnv<T>;
+
+    static constexpr int LANES = 8;
+
+    struct Lanes
+    {
+        alignas(64) T x[3][LANES];
+        alignas(64) T y[3][LANES];
+        alignas(64) T vx[3][LANES];
+        alignas(64) T vy[3][LANES];
+        alignas(64) T ax[3][LANES];
+        alignas(64) T ay[3][LANES];
+        alignas(64) T pot[LANES];
+
+        void load(int lane, const SimT& sim);
+        void store(int lane, SimT& sim) const;
+    };
+
+    // progress sims[0..count) until each aborts or env.max_iter is reached (count <= LANES)
+    static void integrate(SimT* sims, int count, const Env& env);
+    static void integrate(SimT* sims, int count, const Env& env, KernelISA isa);
+
+    static SIM_TARGET_BASE   void integrate_sse2(SimT* sims, int count, const Env& env);
+    static SIM_TARGET_AVX2   void integrate_avx2(SimT* sims, int count, const Env& env);
+    static SIM_TARGET_AVX512 void integrate_avx512(SimT* sims, int count, const Env& env);
+
+private:
+
+    static void step(Lanes& s, const Env& env);
+    #if SIM_WASM_SIMD128
+    static void step_simd128(Lanes& s, const Env& env); // f64 only
+    #endif
+    static u64  integrateLanes(SimT* sims, int count, const Env& env);
+};
+
+/// ─────── SimGrid ───────
+//
+// Every velocity configuration sim_i in [0, SIM_COUNT) for one C position.
+//
+// setup() lays sims[] out by configuration (sims[i] is configuration i).
+// run() packs the sims the pre-filter left for integration to the front and
+// its fast-track candidates to the back, so afterwards sims[k] is
+// configuration order[k] for those slots (slots in between are stale). Map
+// back through order[], or use best_sim / bestSimConfig(), which are always
+// configuration indices.
+
+template<
+    class T, 
+    int VEL_GRID_DIM, 
+    template<class> class StopPolicy = StopPolicy_MaxDist,
+    bool MULTI_THREAD=true
+>
+struct SimGrid
+{
+    #define SimGridTmpl  template<class T, int VEL_GRID_DIM, template<class> class StopPolicy, bool MULTI_THREAD>
+    #define SimGridID    SimGrid<T, VEL_GRID_DIM, StopPolicy, MULTI_THREAD>
+
+    using SimT = Sim<T, StopPolicy>;
+    using Env = SimEnv<T>;
+    using Vec = Vec2<T>;
+    using Kernel = SimKernel<T, StopPolicy>;
+
+    const Env& env;
+
+    static constexpr int VEL_GRID_LEN = (VEL_GRID_DIM * VEL_GRID_DIM);
+    static constexpr int SIM_COUNT = VEL_GRID_LEN * VEL_GRID_LEN;
+    static constexpr int BATCH_COUNT = (SIM_COUNT + Kernel::LANES - 1) / Kernel::LANES;
+
+    [[no_unique_address]] StopPolicy<T> unstable_rule;
+
+    alignas(64) SimT sims[SIM_COUNT]; // after run(): the integrated sims, packed (see order)
+    int order[SIM_COUNT];  // sims[k] is velocity configuration order[k] (identity after setup())
+    //int best_stability = 0;
+    StopResult best_stability;
+    int best_sim = 0;           // configuration index (not a sims[] slot)
+    int best_iter = 0;
+    int diverged_count = 0;     // sims aborted as StopResult::DIVERGED in last run()
+    int ruled_out_count = 0;    // sims removed by the pre-filter in last run()
+    int fast_tracked_count = 0; // sims left unintegrated by a fast-track candidate that lasted the last run()
+    Vec start_pos{};
+
+    SimGrid(const Env& e) : env(e) {}
+
+    void setup(Vec c_pos);
+    void setupSim(int sim_i, SimT& sim) { setupSim(env, start_pos, sim_i, sim); }
+
+    // velocity configuration sim_i at c_pos, without needing a grid
+    static void setupSim(const Env& env, Vec c_pos, int sim_i, SimT& sim);
+    static void startingVelocities(T max_vel, int sim_i, Vec& vel_a, Vec& vel_b, Vec& vel_c);
+    void run(); // progress to env.max_iter (or until all unstable)
+
+    // integrates sims[first, first + count) in lane batches / ranks their results
+    void integrate(int first, int count, KernelISA isa);
+    void rank(int first, int count);
+
+    // call after run(). RULED_OUT if the pre-filter removed every configuration,
+    // DIVERGED if every remaining one diverged (best_iter is 0 for both)
+    StopResult bestStability() const { return best_stability; }
+    int        bestIter() const      { return best_iter; }
+    SimT       bestSimConfig() { SimT s; setupSim(best_sim, s); return s; }
+};
+
+SIM_END;
+
+#include "orbit_sim.hpp"
\ No newline at end of file
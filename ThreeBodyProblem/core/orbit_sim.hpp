@@ -0,0 +1,864 @@
+#include "sim_types.h"
+
+SIM_BEG;
+using namespace bl;
+
+SimTmpl T SimID::pairwise_gravity(Particle<T>& p, Particle<T>& q, const T G, const T soft2)
+{
+    const T rx = q.x - p.x;
+    const T ry = q.y - p.y;
+    const T r2 = rx * rx + ry * ry + soft2;
+    const T inv_r = T(1) / sqrt(r2);
+    const T inv_r3 = inv_r * inv_r * inv_r;
+    const T scale = G * inv_r3;
+    const T fx = scale * rx;
+    const T fy = scale * ry;
+    p.ax += fx; p.ay += fy;
+    q.ax -= fx; q.ay -= fy;
+    return G * inv_r; // -potential
+}
+
+SimTmpl void SimID::compute_accels(Particle<T>& a, Particle<T>& b, Particle<T>& c, const T G, const T soft2)
+{
+    a.ax = a.ay = b.ax = b.ay = c.ax = c.ay = T(0);
+    const T p_ab = pairwise_gravity(a, b, G, soft2);
+    const T p_bc = pairwise_gravity(b, c, G, soft2);
+    const T p_ca = pairwise_gravity(c, a, G, soft2);
+    pot = -(p_ab + p_bc + p_ca);
+}
+
+SimTmpl T SimID::energy() const
+{
+    const T kinetic = T(0.5) * (
+        a.vx * a.vx + a.vy * a.vy +
+        b.vx * b.vx + b.vy * b.vy +
+        c.vx * c.vx + c.vy * c.vy);
+    return kinetic + pot;
+}
+
+SimTmpl T SimID::angularMomentum() const
+{
+    return (a.x * a.vy - a.y * a.vx) +
+           (b.x * b.vy - b.y * b.vx) +
+           (c.x * c.vy - c.y * c.vx);
+}
+
+SimTmpl bool SimID::diverged() const
+{
+    using std::abs;
+    return (check_energy && abs(energy() - energy0) > energy_err_max) ||
+           (check_momentum && abs(angularMomentum() - momentum0) > momentum_err_max);
+}
+
+SimTmpl StopResult SimID::stability() const
+{
+    if (diverged())
+        return StopResult(StopResult::DIVERGED, iter);
+
+    return unstable_rule.stability(iter, a, b, c);
+}
+
+SimTmpl void SimID::setup(const Env& env, Vec pos, Vec vel_a, Vec vel_b, Vec vel_c)
+{
+    // a/b always start at (-1,0) and (1,0)
+    // c is the only pos needed to create any triangular shape
+    a.set(-1.0, 0);
+    b.set(1.0, 0);
+    c.set(pos);
+
+    a.vx = vel_a.x; a.vy = vel_a.y;
+    b.vx = vel_b.x; b.vy = vel_b.y;
+    c.vx = vel_c.x; c.vy = vel_c.y;
+
+    begin(env);
+}
+
+SimTmpl void SimID::setup(const Env& env, const Vec (&pos)[3], const Vec (&vel)[3])
+{
+    a.set(pos[0]); b.set(pos[1]); c.set(pos[2]);
+
+    a.vx = vel[0].x; a.vy = vel[0].y;
+    b.vx = vel[1].x; b.vy = vel[1].y;
+    c.vx = vel[2].x; c.vy = vel[2].y;
+
+    begin(env);
+}
+
+SimTmpl template<class U> void SimID::setup(const Env& env, const Sim<U, StopPolicy>& src)
+{
+    Particle<T>* dst[3] = { &a, &b, &c };
+    const Particle<U>* from[3] = { &src.bodyA(), &src.bodyB(), &src.bodyC() };
+    for (int i = 0; i < 3; i++)
+    {
+        dst[i]->x = T(from[i]->x);   dst[i]->y = T(from[i]->y);
+        dst[i]->vx = T(from[i]->vx); dst[i]->vy = T(from[i]->vy);
+    }
+
+    begin(env);
+}
+
+SimTmpl void SimID::begin(const Env& env)
+{
+    iter = 0;
+
+    // reference values for drift monitoring
+    compute_accels(a, b, c, env.G, env.soft2);
+    energy0 = energy();
+    momentum0 = angularMomentum();
+
+    using std::abs;
+    using std::sqrt;
+    const T kinetic = energy0 - pot;
+    const T energy_scale = abs(kinetic) + abs(pot);
+
+    // |r||v| per body, with a circular-orbit speed floor so bodies at rest still get a scale
+    const T v_floor = sqrt(abs(pot) / T(3));
+    const T momentum_scale =
+        sqrt(a.mag2()) * (sqrt(a.vx * a.vx + a.vy * a.vy) + v_floor) +
+        sqrt(b.mag2()) * (sqrt(b.vx * b.vx + b.vy * b.vy) + v_floor) +
+        sqrt(c.mag2()) * (sqrt(c.vx * c.vx + c.vy * c.vy) + v_floor);
+
+    energy_err_max = env.energy_tolerance * energy_scale;
+    momentum_err_max = env.momentum_tolerance * momentum_scale;
+    check_energy = env.energy_tolerance > T(0);
+    check_momentum = env.momentum_tolerance > T(0);
+
+    unstable_rule.init(&env, a, b, c);
+}
+
+SimTmpl void SimID::leapfrog(const Env& env, const T dt)
+{
+    const T half = T(0.5);
+
+    compute_accels(a, b, c, env.G, env.soft2);
+
+    // 2) update velocity (half-kick)
+    a.vx += a.ax * (half * dt); a.vy += a.ay * (half * dt);
+    b.vx += b.ax * (half * dt); b.vy += b.ay * (half * dt);
+    c.vx += c.ax * (half * dt); c.vy += c.ay * (half * dt);
+
+    // 3) update pos
+    a.x += a.vx * dt; a.y += a.vy * dt;
+    b.x += b.vx * dt; b.y += b.vy * dt;
+    c.x += c.vx * dt; c.y += c.vy * dt;
+
+    compute_accels(a, b, c, env.G, env.soft2);
+
+    // 5) update velocity (half-kick)
+    a.vx += a.ax * (half * dt); a.vy += a.ay * (half * dt);
+    b.vx += b.ax * (half * dt); b.vy += b.ay * (half * dt);
+    c.vx += c.ax * (half * dt); c.vy += c.ay * (half * dt);
+}
+
+SimTmpl void SimID::progress(const Env& env)
+{
+    leapfrog(env, env.dt);
+    iter++;
+
+    if constexpr (requires { unstable_rule.observe(iter, a, b, c); })
+        unstable_rule.observe(iter, a, b, c);
+}
+
+SimTmpl void SimID::regress(const Env& env)
+{
+    // kick-drift-kick with -dt exactly undoes a step (up to rounding)
+    leapfrog(env, -env.dt);
+    iter--;
+}
+
+//template<class T>
+//bool Sim<T>::progress(const SimEnv& env)
+//{
+//    const T dt = env.dt;
+//    const T G = env.G;
+//    const T soft2 = env.soft2;
+//
+//    // update accelerations
+//    a.ax = 0; a.ay = 0;
+//    b.ax = 0; b.ay = 0;
+//    c.ax = 0; c.ay = 0;
+//
+//    pairwise_gravity(a, b, G, soft2);
+//    pairwise_gravity(b, c, G, soft2);
+//    pairwise_gravity(c, a, G, soft2);
+//
+//    // update velocities
+//    a.vx += a.ax * dt; a.vy += a.ay * dt;
+//    b.vx += b.ax * dt; b.vy += b.ay * dt;
+//    c.vx += c.ax * dt; c.vy += c.ay * dt;
+//
+//    // update positions
+//    a.x += a.vx * dt; a.y += a.vy * dt;
+//    b.x += b.vx * dt; b.y += b.vy * dt;
+//    c.x += c.vx * dt; c.y += c.vy * dt;
+//
+//    // check stable
+//    if (iter++ % 10 == 0) is_unstable |= unstable();
+//    return !is_unstable;
+//}
+
+
+/// ─────── analytic pre-filter ───────
+
+template<class T>
+PrefilterClass prefilterClassify(
+    const SimEnv<T>& env,
+    const Particle<T>& a,
+    const Particle<T>& b,
+    const Particle<T>& c,
+    T energy,
+    bool survival)
+{
+    using std::sqrt;
+
+    // fast-tracking trusts the unsoftened two-body picture of the inner pair,
+    // so it must be well resolved by dt and stay far outside the softening length
+    constexpr f64 min_inner_period_steps = 200;
+    constexpr f64 min_inner_pericentre_soft = 10; // in units of sqrt(soft2)
+
+    if (env.prefilter_unbound && !(energy < T(0)))
+        return PrefilterClass::RULED_OUT;
+
+    if (!env.prefilter_hierarchical || !survival)
+        return PrefilterClass::INTEGRATE;
+
+    // inner binary = closest pair
+    const Particle<T>* p[3] = { &a, &b, &c };
+    int in0 = 0, in1 = 1, out = 2;
+    {
+        const T d_ab = sq(a.x - b.x) + sq(a.y - b.y);
+        const T d_bc = sq(b.x - c.x) + sq(b.y - c.y);
+        const T d_ca = sq(c.x - a.x) + sq(c.y - a.y);
+        if (d_bc < d_ab && d_bc <= d_ca) { in0 = 1; in1 = 2; out = 0; }
+        else if (d_ca < d_ab && d_ca < d_bc) { in0 = 2; in1 = 0; out = 1; }
+    }
+
+    const Particle<T>& i0 = *p[in0];
+    const Particle<T>& i1 = *p[in1];
+    const Particle<T>& o = *p[out];
+
+    // inner orbit (reduced two-body problem, total mass 2)
+    const T mu_in = env.G * T(2);
+    const T rx = i1.x - i0.x, ry = i1.y - i0.y;
+    const T vx = i1.vx - i0.vx, vy = i1.vy - i0.vy;
+    const T r_in = sqrt(rx * rx + ry * ry);
+    const T e_in_energy = T(0.5) * (vx * vx + vy * vy) - mu_in / r_in;
+    if (!(e_in_energy < T(0)))
+        return PrefilterClass::INTEGRATE;
+
+    const T a_in = -mu_in / (T(2) * e_in_energy);
+    const T h_in = rx * vy - ry * vx;
+    const T ecc_in = sqrt(std::max(T(0), T(1) + T(2) * e_in_energy * h_in * h_in / (mu_in * mu_in)));
+
+    const f64 period_in = 2.0 * std::numbers::pi * std::sqrt((f64)(a_in * a_in * a_in / mu_in));
+    if (!(period_in > min_inner_period_steps * (f64)env.dt))
+        return PrefilterClass::INTEGRATE;
+
+    const f64 peri_in = (f64)(a_in * (T(1) - ecc_in));
+    if (!(peri_in > min_inner_pericentre_soft * std::sqrt((f64)env.soft2)))
+        return PrefilterClass::INTEGRATE;
+
+    // outer orbit: third body around the inner pair's centre of mass (total mass 3)
+    const T mu_out = env.G * T(3);
+    const T cx = T(0.5) * (i0.x + i1.x), cy = T(0.5) * (i0.y + i1.y);
+    const T cvx = T(0.5) * (i0.vx + i1.vx), cvy = T(0.5) * (i0.vy + i1.vy);
+    const T Rx = o.x - cx, Ry = o.y - cy;
+    const T Vx = o.vx - cvx, Vy = o.vy - cvy;
+    const T R = sqrt(Rx * Rx + Ry * Ry);
+    const T e_out_energy = T(0.5) * (Vx * Vx + Vy * Vy) - mu_out / R;
+    if (!(e_out_energy < T(0)))
+        return PrefilterClass::INTEGRATE;
+
+    const T a_out = -mu_out / (T(2) * e_out_energy);
+    const T h_out = Rx * Vy - Ry * Vx;
+    const T ecc_out = sqrt(std::max(T(0), T(1) + T(2) * e_out_energy * h_out * h_out / (mu_out * mu_out)));
+    if (!(ecc_out < T(1)))
+        return PrefilterClass::INTEGRATE;
+
+    // Mardling & Aarseth (2001), coplanar prograde: Rp_out / a_in > 2.8 (1+q)^(2/5) (1+e)^(2/5) (1-e)^(-1/5)
+    // (an empirical bound, evaluated in f64 whatever T is)
+    const f64 q_out = 0.5; // m_out / m_in
+    const f64 e_out = (f64)ecc_out;
+    const T rp_out = a_out * (T(1) - ecc_out);
+    const T bound = T(2.8 *
+        std::pow(1.0 + q_out, 0.4) *
+        std::pow(1.0 + e_out, 0.4) /
+        std::pow(1.0 - e_out, 0.2));
+
+    if (!(rp_out > bound * a_in))
+        return PrefilterClass::INTEGRATE;
+
+    // every body must stay inside max_dist (bounds from the system's centre of mass)
+    const T gx = (a.x + b.x + c.x) / T(3), gy = (a.y + b.y + c.y) / T(3);
+    const T g_vx = (a.vx + b.vx + c.vx) / T(3), g_vy = (a.vy + b.vy + c.vy) / T(3);
+    if (g_vx * g_vx + g_vy * g_vy > T(0))
+        return PrefilterClass::INTEGRATE; // drifting system, reach depends on run length
+
+    const T apo_out = a_out * (T(1) + ecc_out);
+    const T apo_in = a_in * (T(1) + ecc_in);
+    const T reach = sqrt(gx * gx + gy * gy) +
+        std::max(apo_out * T(2) / T(3), apo_out / T(3) + apo_in / T(2));
+
+    if (!(reach < T(SimEnv<T>::max_dist)))
+        return PrefilterClass::INTEGRATE;
+
+    return PrefilterClass::FAST_TRACK;
+}
+
+/// ─────── SimKeyframes ───────
+
+template<class SimT>
+bool SimKeyframes<SimT>::restore(int iter, SimT& out) const
+{
+    if (iter < 0 || iter % interval != 0) return false;
+    const size_t i = (size_t)(iter / interval);
+    if (i >= keys.size()) return false;
+
+    out = keys[i].sim;
+    out.iter = keys[i].iter;
+    return true;
+}
+
+template<class SimT>
+template<class Env>
+void SimKeyframes<SimT>::seek(const Env& env, int iter, SimT& out) const
+{
+    if (keys.empty()) return;
+
+    iter = std::clamp(iter, 0, length);
+    const size_t i = std::min((size_t)(iter / interval), keys.size() - 1);
+
+    out = keys[i].sim;
+    out.iter = keys[i].iter;
+    while (out.curIter() < iter)
+        out.progress(env);
+}
+
+/// ─────── PeriodDetector ───────
+
+template<class T>
+bool PeriodDetector<T>::observe(int iter, const Particle<T>& a, const Particle<T>& b, const Particle<T>& c)
+{
+    if (period > 0) return true;
+
+    // state relative to the centre of mass (equal masses)
+    const T third = T(1) / T(3);
+    const T cx = (a.x + b.x + c.x) * third,     cy = (a.y + b.y + c.y) * third;
+    const T cvx = (a.vx + b.vx + c.vx) * third, cvy = (a.vy + b.vy + c.vy) * third;
+
+    const T y = a.y - cy;
+    const T now[DIMS] = {
+        a.x - cx, a.vx - cvx, a.vy - cvy,
+        b.x - cx, b.y - cy, b.vx - cvx, b.vy - cvy
+    };
+
+    bool found = false;
+    if (has_prev && prev_y < T(0) && y >= T(0))
+    {
+        // interpolate onto the section, then quantise
+        const T f = prev_y / (prev_y - y);
+        i16 q[DIMS];
+        for (int d = 0; d < DIMS; d++)
+        {
+            const T v = (prev[d] + (now[d] - prev[d]) * f) * inv_quantum[d];
+            const T r = std::clamp(v, T(-32767), T(32767));
+            q[d] = (i16)(int)(r < T(0) ? r - T(0.5) : r + T(0.5));
+        }
+        found = crossing(iter, q);
+    }
+
+    for (int d = 0; d < DIMS; d++) prev[d] = now[d];
+    prev_y = y;
+    has_prev = true;
+    return found;
+}
+
+template<class T>
+bool PeriodDetector<T>::crossing(int iter, const i16 (&q)[DIMS])
+{
+    crossings++;
+
+    // look for a match in this cell and its neighbours (quantisation boundaries)
+    for (int d0 = -1; d0 <= 1; d0++)
+    {
+        for (int d2 = -1; d2 <= 1; d2++)
+        {
+            const u32 cell = cellKey(q[0] + d0, q[2] + d2);
+            for (int p = 0; p < PROBE_LEN; p++)
+            {
+                const Slot& slot = table[(cell + p) & (TABLE_SIZE - 1)];
+                if (slot.iter < 0 || slot.cell != cell) continue;
+                if (iter - slot.iter < min_period) continue;
+
+                bool match = true;
+                for (int d = 0; d < DIMS && match; d++)
+                    match = std::abs((int)slot.q[d] - (int)q[d]) <= 1;
+
+                if (match)
+                {
+                    period = iter - slot.iter;
+                    period_beg = slot.iter;
+                    return true;
+                }
+            }
+        }
+    }
+
+    // insert: first free slot in the probe window, else evict the oldest there
+    const u32 cell = cellKey(q[0], q[2]);
+    Slot* target = &table[cell & (TABLE_SIZE - 1)];
+    for (int p = 0; p < PROBE_LEN; p++)
+    {
+        Slot& slot = table[(cell + p) & (TABLE_SIZE - 1)];
+        if (slot.iter < 0) { target = &slot; break; }
+        if (slot.iter < target->iter) target = &slot;
+    }
+
+    target->iter = iter;
+    target->cell = cell;
+    for (int d = 0; d < DIMS; d++) target->q[d] = q[d];
+    return false;
+}
+
+/// ─────── SimKernel ───────
+
+#define SimKernelTmpl  template<class T, template<class> class StopPolicy>
+#define SimKernelID    SimKernel<T, StopPolicy>
+
+SimKernelTmpl void SimKernelID::Lanes::load(int lane, const SimT& sim)
+{
+    const Particle<T>* p[3] = { &sim.a, &sim.b, &sim.c };
+    for (int k = 0; k < 3; k++)
+    {
+        x[k][lane] = p[k]->x;   y[k][lane] = p[k]->y;
+        vx[k][lane] = p[k]->vx; vy[k][lane] = p[k]->vy;
+        ax[k][lane] = p[k]->ax; ay[k][lane] = p[k]->ay;
+    }
+    pot[lane] = sim.pot;
+}
+
+SimKernelTmpl void SimKernelID::Lanes::store(int lane, SimT& sim) const
+{
+    Particle<T>* p[3] = { &sim.a, &sim.b, &sim.c };
+    for (int k = 0; k < 3; k++)
+    {
+        p[k]->x = x[k][lane];   p[k]->y = y[k][lane];
+        p[k]->vx = vx[k][lane]; p[k]->vy = vy[k][lane];
+        p[k]->ax = ax[k][lane]; p[k]->ay = ay[k][lane];
+    }
+    sim.pot = pot[lane];
+}
+
+SimKernelTmpl void SimKernelID::step(Lanes& s, const Env& env)
+{
+    #if SIM_WASM_SIMD128
+    if constexpr (std::is_same_v<T, f64>)
+    {
+        step_simd128(s, env);
+        return;
+    }
+    #endif
+
+    const T dt = env.dt, half = T(0.5), G = env.G, soft2 = env.soft2;
+
+    // same pair order / accumulation order as Sim::compute_accels(), returns -potential
+    auto pair = [&](T px, T py, T qx, T qy, T& pax, T& pay, T& qax, T& qay) -> T
+    {
+        const T rx = qx - px;
+        const T ry = qy - py;
+        const T r2 = rx * rx + ry * ry + soft2;
+        const T inv_r = T(1) / sqrt(r2);
+        const T inv_r3 = inv_r * inv_r * inv_r;
+        const T scale = G * inv_r3;
+        const T fx = scale * rx;
+        const T fy = scale * ry;
+        pax += fx; pay += fy;
+        qax -= fx; qay -= fy;
+        return G * inv_r;
+    };
+
+    for (int l = 0; l < LANES; l++)
+    {
+        T ax0 = 0, ay0 = 0, ax1 = 0, ay1 = 0, ax2 = 0, ay2 = 0;
+        pair(s.x[0][l], s.y[0][l], s.x[1][l], s.y[1][l], ax0, ay0, ax1, ay1);
+        pair(s.x[1][l], s.y[1][l], s.x[2][l], s.y[2][l], ax1, ay1, ax2, ay2);
+        pair(s.x[2][l], s.y[2][l], s.x[0][l], s.y[0][l], ax2, ay2, ax0, ay0);
+
+        // half-kick
+        T vx0 = s.vx[0][l] + ax0 * (half * dt), vy0 = s.vy[0][l] + ay0 * (half * dt);
+        T vx1 = s.vx[1][l] + ax1 * (half * dt), vy1 = s.vy[1][l] + ay1 * (half * dt);
+        T vx2 = s.vx[2][l] + ax2 * (half * dt), vy2 = s.vy[2][l] + ay2 * (half * dt);
+
+        // drift
+        const T x0 = s.x[0][l] + vx0 * dt, y0 = s.y[0][l] + vy0 * dt;
+        const T x1 = s.x[1][l] + vx1 * dt, y1 = s.y[1][l] + vy1 * dt;
+        const T x2 = s.x[2][l] + vx2 * dt, y2 = s.y[2][l] + vy2 * dt;
+
+        ax0 = ay0 = ax1 = ay1 = ax2 = ay2 = T(0);
+        const T p01 = pair(x0, y0, x1, y1, ax0, ay0, ax1, ay1);
+        const T p12 = pair(x1, y1, x2, y2, ax1, ay1, ax2, ay2);
+        const T p20 = pair(x2, y2, x0, y0, ax2, ay2, ax0, ay0);
+        s.pot[l] = -(p01 + p12 + p20);
+
+        // half-kick
+        vx0 += ax0 * (half * dt); vy0 += ay0 * (half * dt);
+        vx1 += ax1 * (half * dt); vy1 += ay1 * (half * dt);
+        vx2 += ax2 * (half * dt); vy2 += ay2 * (half * dt);
+
+        s.x[0][l] = x0;   s.y[0][l] = y0;   s.x[1][l] = x1;   s.y[1][l] = y1;   s.x[2][l] = x2;   s.y[2][l] = y2;
+        s.vx[0][l] = vx0; s.vy[0][l] = vy0; s.vx[1][l] = vx1; s.vy[1][l] = vy1; s.vx[2][l] = vx2; s.vy[2][l] = vy2;
+        s.ax[0][l] = ax0; s.ay[0][l] = ay0; s.ax[1][l] = ax1; s.ay[1][l] = ay1; s.ax[2][l] = ax2; s.ay[2][l] = ay2;
+    }
+}
+
+#if SIM_WASM_SIMD128
+// step() written with f64x2 intrinsics (the wasm autovectorizer tends to leave
+// the pair lambda scalar). Same operation order, so results match step().
+SimKernelTmpl void SimKernelID::step_simd128(Lanes& s, const Env& env)
+{
+    using v128 = v128_t;
+
+    const v128 dt = wasm_f64x2_splat(env.dt);
+    const v128 half_dt = wasm_f64x2_mul(wasm_f64x2_splat(0.5), dt);
+    const v128 G = wasm_f64x2_splat(env.G);
+    const v128 soft2 = wasm_f64x2_splat(env.soft2);
+    const v128 one = wasm_f64x2_splat(1.0);
+    const v128 zero = wasm_f64x2_splat(0.0);
+
+    auto pair = [&](v128 px, v128 py, v128 qx, v128 qy, v128& pax, v128& pay, v128& qax, v128& qay) -> v128
+    {
+        const v128 rx = wasm_f64x2_sub(qx, px);
+        const v128 ry = wasm_f64x2_sub(qy, py);
+        const v128 r2 = wasm_f64x2_add(wasm_f64x2_add(wasm_f64x2_mul(rx, rx), wasm_f64x2_mul(ry, ry)), soft2);
+        const v128 inv_r = wasm_f64x2_div(one, wasm_f64x2_sqrt(r2));
+        const v128 inv_r3 = wasm_f64x2_mul(wasm_f64x2_mul(inv_r, inv_r), inv_r);
+        const v128 scale = wasm_f64x2_mul(G, inv_r3);
+        const v128 fx = wasm_f64x2_mul(scale, rx);
+        const v128 fy = wasm_f64x2_mul(scale, ry);
+        pax = wasm_f64x2_add(pax, fx); pay = wasm_f64x2_add(pay, fy);
+        qax = wasm_f64x2_sub(qax, fx); qay = wasm_f64x2_sub(qay, fy);
+        return wasm_f64x2_mul(G, inv_r);
+    };
+
+    for (int l = 0; l < LANES; l += 2)
+    {
+        v128 x[3], y[3], vx[3], vy[3], ax[3], ay[3];
+        for (int k = 0; k < 3; k++)
+        {
+            x[k] = wasm_v128_load(&s.x[k][l]);
+            y[k] = wasm_v128_load(&s.y[k][l]);
+            ax[k] = ay[k] = zero;
+        }
+
+        pair(x[0], y[0], x[1], y[1], ax[0], ay[0], ax[1], ay[1]);
+        pair(x[1], y[1], x[2], y[2], ax[1], ay[1], ax[2], ay[2]);
+        pair(x[2], y[2], x[0], y[0], ax[2], ay[2], ax[0], ay[0]);
+
+        for (int k = 0; k < 3; k++)
+        {
+            // half-kick
+            vx[k] = wasm_f64x2_add(wasm_v128_load(&s.vx[k][l]), wasm_f64x2_mul(ax[k], half_dt));
+            vy[k] = wasm_f64x2_add(wasm_v128_load(&s.vy[k][l]), wasm_f64x2_mul(ay[k], half_dt));
+
+            // drift
+            x[k] = wasm_f64x2_add(x[k], wasm_f64x2_mul(vx[k], dt));
+            y[k] = wasm_f64x2_add(y[k], wasm_f64x2_mul(vy[k], dt));
+            ax[k] = ay[k] = zero;
+        }
+
+        const v128 p01 = pair(x[0], y[0], x[1], y[1], ax[0], ay[0], ax[1], ay[1]);
+        const v128 p12 = pair(x[1], y[1], x[2], y[2], ax[1], ay[1], ax[2], ay[2]);
+        const v128 p20 = pair(x[2], y[2], x[0], y[0], ax[2], ay[2], ax[0], ay[0]);
+        wasm_v128_store(&s.pot[l], wasm_f64x2_neg(wasm_f64x2_add(wasm_f64x2_add(p01, p12), p20)));
+
+        for (int k = 0; k < 3; k++)
+        {
+            // half-kick
+            vx[k] = wasm_f64x2_add(vx[k], wasm_f64x2_mul(ax[k], half_dt));
+            vy[k] = wasm_f64x2_add(vy[k], wasm_f64x2_mul(ay[k], half_dt));
+
+            wasm_v128_store(&s.x[k][l], x[k]);   wasm_v128_store(&s.y[k][l], y[k]);
+            wasm_v128_store(&s.vx[k][l], vx[k]); wasm_v128_store(&s.vy[k][l], vy[k]);
+            wasm_v128_store(&s.ax[k][l], ax[k]); wasm_v128_store(&s.ay[k][l], ay[k]);
+        }
+    }
+}
+#endif
+
+SimKernelTmpl u64 SimKernelID::integrateLanes(SimT* sims, int count, const Env& env)
+{
+    Lanes s;
+    bool active[LANES];
+    int  beg_iter[LANES];
+
+    // unused lanes integrate a copy of lane 0 and are never stored
+    for (int l = 0; l < LANES; l++)
+    {
+        const int src = (l < count) ? l : 0;
+        s.load(l, sims[src]);
+        active[l] = (l < count);
+        beg_iter[l] = sims[src].iter;
+    }
+
+    int alive = count;
+    int i = 0;
+    while (i < env.max_iter && alive > 0)
+    {
+        step(s, env);
+
+        // per-step hook for policies that watch the whole trajectory
+        if constexpr (requires (SimT& sim, Particle<T>& p) { sim.unstable_rule.observe(0, p, p, p); })
+        {
+            for (int l = 0; l < count; l++)
+            {
+                if (!active[l]) continue;
+
+                Particle<T> p[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    p[k].x = s.x[k][l];   p[k].y = s.y[k][l];
+                    p[k].vx = s.vx[k][l]; p[k].vy = s.vy[k][l];
+                }
+                sims[l].unstable_rule.observe(beg_iter[l] + i + 1, p[0], p[1], p[2]);
+            }
+        }
+
+        if (i % env.escape_freq == 0)
+        {
+            for (int l = 0; l < count; l++)
+            {
+                if (!active[l]) continue;
+
+                SimT& sim = sims[l];
+                s.store(l, sim);
+                sim.iter = beg_iter[l] + i + 1;
+
+                if ((int)sim.stability().type & (int)StopResult::ABORT_MASK)
+                {
+                    active[l] = false;
+                    alive--;
+                }
+            }
+        }
+        i++;
+    }
+
+    for (int l = 0; l < count; l++)
+    {
+        if (!active[l]) continue;
+        s.store(l, sims[l]);
+        sims[l].iter = beg_iter[l] + i;
+    }
+
+    return (u64)i * LANES;
+}
+
+SimKernelTmpl void SimKernelID::integrate_sse2(SimT* sims, int count, const Env& env)
+{
+    kernelTelemetry().record(KernelISA::SSE2, count, integrateLanes(sims, count, env));
+}
+
+SimKernelTmpl void SimKernelID::integrate_avx2(SimT* sims, int count, const Env& env)
+{
+    kernelTelemetry().record(KernelISA::AVX2, count, integrateLanes(sims, count, env));
+}
+
+SimKernelTmpl void SimKernelID::integrate_avx512(SimT* sims, int count, const Env& env)
+{
+    kernelTelemetry().record(KernelISA::AVX512, count, integrateLanes(sims, count, env));
+}
+
+SimKernelTmpl void SimKernelID::integrate(SimT* sims, int count, const Env& env, KernelISA isa)
+{
+    switch (isa)
+    {
+    #if SIM_KERNEL_DISPATCH
+    case KernelISA::AVX512: integrate_avx512(sims, count, env); break;
+    case KernelISA::AVX2:   integrate_avx2(sims, count, env);   break;
+    #endif
+    default:                integrate_sse2(sims, count, env);   break;
+    }
+}
+
+SimKernelTmpl void SimKernelID::integrate(SimT* sims, int count, const Env& env)
+{
+    integrate(sims, count, env, activeKernelISA());
+}
+
+/// ─────── SimGrid ───────
+
+SimGridTmpl void SimGridID::setup(Vec c_pos) {
+    start_pos = c_pos;
+    for (int s = 0; s < SIM_COUNT; s++)
+    {
+        setupSim(s, sims[s]);
+        order[s] = s;
+    }
+}
+
+SimGridTmpl void SimGridID::setupSim(const Env& env, Vec c_pos, int sim_i, SimT& sim)
+{
+    Vec vel_a, vel_b, vel_c;
+    startingVelocities(env.max_vel, sim_i, vel_a, vel_b, vel_c);
+    sim.setup(env, c_pos, vel_a, vel_b, vel_c);
+}
+
+SimGridTmpl void SimGridID::startingVelocities(
+    T max_vel,
+    int sim_i, 
+    Vec& vel_a, 
+    Vec& vel_b,
+    Vec& vel_c)
+{
+    int iU = sim_i / VEL_GRID_LEN;
+    int iW = sim_i % VEL_GRID_LEN;
+
+    T dim_cen = T(VEL_GRID_DIM - 1) / T(2);
+
+    T ux = (T(iU % VEL_GRID_DIM) - dim_cen) * max_vel;
+    T uy = (T(iU / VEL_GRID_DIM) - dim_cen) * max_vel;
+    T wx = (T(iW % VEL_GRID_DIM) - dim_cen) * max_vel;
+    T wy = (T(iW / VEL_GRID_DIM) - dim_cen) * max_vel;
+
+    T vax = -(ux + wx) / T(3);
+    T vay = -(uy + wy) / T(3);
+
+    vel_a.set(vax, vay);
+    vel_b.set(vax + ux, vay + uy);
+    vel_c.set(vax + wx, vay + wy);
+}
+
+SimGridTmpl void SimGridID::integrate(int first, int count, KernelISA isa)
+{
+    const int batch_count = (count + Kernel::LANES - 1) / Kernel::LANES;
+    auto integrateBatch = [this, isa, first, count](int batch)
+    {
+        const int beg = batch * Kernel::LANES;
+        Kernel::integrate(sims + first + beg, std::min(Kernel::LANES, count - beg), env, isa);
+    };
+
+    if constexpr (MULTI_THREAD)
+    {
+        // one task per helper thread (not per batch), each pulls batches until
+        // none are left. The calling thread pulls too instead of just waiting
+        std::atomic<int> next_batch{ 0 };
+        auto drain = [&integrateBatch, &next_batch, batch_count]()
+        {
+            for (int b; (b = next_batch.fetch_add(1, std::memory_order_relaxed)) < batch_count; )
+                integrateBatch(b);
+        };
+
+        const int hw = std::max(1, (int)std::thread::hardware_concurrency());
+        const int helpers = std::min(batch_count, hw) - 1;
+
+        std::future<void> results[BATCH_COUNT];
+        for (int h = 0; h < helpers; h++)
+            results[h] = submitSimTask(drain);
+
+        drain();
+        for (int h = 0; h < helpers; h++)
+            results[h].get(); // wait for in-flight batches
+    }
+    else // single-threaded
+    {
+        for (int b = 0; b < batch_count; b++)
+            integrateBatch(b);
+    }
+}
+
+SimGridTmpl void SimGridID::rank(int first, int count)
+{
+    for (int k = first; k < first + count; k++)
+    {
+        SimT& sim = sims[k];
+        StopResult sim_stability = sim.stability();
+
+        if (sim_stability.type == StopResult::DIVERGED)
+            diverged_count++;
+
+        if (sim_stability.excluded())
+            continue;
+
+        if (StopPolicy<T>::isBetterResult(sim_stability, best_stability))
+        {
+            best_sim = order[k];
+            best_iter = sim.curIter();
+            best_stability = sim_stability;
+        }
+    }
+}
+
+SimGridTmpl void SimGridID::run()
+{
+    best_stability = StopResult(StopResult::INVALID, -1.0);
+    best_sim = 0;
+    best_iter = 0;
+    diverged_count = 0;
+    ruled_out_count = 0;
+    fast_tracked_count = 0;
+
+    // pre-filter: only configurations it can't classify are integrated
+    constexpr bool survival = StopPolicy<T>::ranks_by_survival;
+    const KernelISA isa = activeKernelISA();
+    int active = 0;
+    int candidates = 0;
+    for (int s = 0; s < SIM_COUNT; s++)
+    {
+        const SimT& sim = sims[s];
+        switch (prefilterClassify(env, sim.bodyA(), sim.bodyB(), sim.bodyC(), sim.energy(), survival))
+        {
+        case PrefilterClass::RULED_OUT:
+            ruled_out_count++;
+            break;
+        case PrefilterClass::FAST_TRACK:
+            // collected at the back of order[], the front holds the sims to integrate
+            order[SIM_COUNT - 1 - candidates++] = s;
+            break;
+        default:
+            order[active++] = s;
+            break;
+        }
+    }
+
+    if (active + candidates == 0)
+    {
+        best_stability = StopResult(StopResult::RULED_OUT, 0.0);
+        return;
+    }
+
+    // pack the lane batches densely: sims[k] is configuration order[k] from
+    // here on (see SimGrid). Sims are set up again rather than moved, so
+    // slots can be filled in any order
+    const int first_candidate = SIM_COUNT - candidates;
+    for (int k = 0; k < SIM_COUNT; k++)
+    {
+        if ((k < active || k >= first_candidate) && order[k] != k)
+            setupSim(order[k], sims[k]);
+    }
+
+    // fast-track candidates run first, in batches of their own. The bound is
+    // analytic, the integration isn't: a candidate is only trusted once it
+    // has survived to max_iter without being excluded. Nothing can outlast it,
+    // so the rest of the grid is skipped
+    if (candidates > 0)
+    {
+        integrate(first_candidate, candidates, isa);
+        rank(first_candidate, candidates);
+
+        if (best_iter >= env.max_iter && !best_stability.excluded())
+        {
+            fast_tracked_count = active;
+            return;
+        }
+    }
+
+    integrate(0, active, isa);
+    rank(0, active);
+
+    // nothing left to rank because every sim drifted past the conservation
+    // tolerances: numerically broken, not an immediate escape
+    if (diverged_count > 0 && diverged_count + ruled_out_count == SIM_COUNT)
+        best_stability = StopResult(StopResult::DIVERGED, 0.0);
+}
+
+SIM_END;
\ No newline at end of file
@@ -0,0 +1,242 @@
+#pragma once
+#include "orbit_sim.h"
+#include <chrono>
+#include <thread>
+
+SIM_BEG;
+
+using namespace bl;
+
+/// ─────── Parareal ───────
+//
+// Parallel-in-time integration of one long orbit. The span is where the stop
+// policy ends the orbit (its first abort, or env.max_iter), estimated by a
+// coarse run so Parareal covers about the span a scan would without paying for
+// a fine serial run first. That span is cut into segments. A coarse leapfrog
+// (dt * coarse_factor) runs serially across all boundaries, the fine leapfrog
+// (env.dt) refines every segment in parallel, and the standard Parareal
+// correction
+//
+//   U[n+1] = G(U'[n]) + F(U[n]) - G(U[n])
+//
+// is iterated until the boundary states stop moving. After k iterations the
+// first k segments are exact, so at most `segments` iterations reproduce the
+// serial result (strongly chaotic orbits can need that many; the report's
+// speedup shows whether it paid off).
+//
+// Only with compare_serial is the span also run serially (afterwards, not
+// counted in parareal_ms), and the boundary states of both runs are compared
+// against env.pos_tolerance.
+
+struct PararealConfig
+{
+    int segments = 0;        // 0 = hardware threads
+    int coarse_factor = 8;   // coarse dt = coarse_factor * env.dt
+    int max_iterations = 0;  // 0 = segments
+    f64 tolerance = 1e-9;    // max boundary state change that counts as converged
+    bool compare_serial = true;
+};
+
+struct PararealReport
+{
+    StopResult span_result;   // where the coarse estimate stops the orbit
+    int span_iters = 0;       // fine steps covered
+    int segments = 0;
+    int iterations = 0;
+    bool converged = false;
+    f64 last_update = 0;     // max boundary change in the last iteration
+
+    f64 max_pos_err = -1;    // vs the serial run at segment boundaries (-1 = not compared)
+    f64 final_pos_err = -1;
+    f64 estimate_ms = 0;     // coarse span estimate
+    f64 parareal_ms = 0;     // end to end, estimate included
+    f64 serial_ms = 0;       // fine serial run of the span (0 = not run)
+
+    bool agrees(f64 pos_tolerance) const { return max_pos_err >= 0 && max_pos_err <= pos_tolerance; }
+    f64  speedup() const                 { return (parareal_ms > 0) ? (serial_ms / parareal_ms) : 0.0; }
+};
+
+template<class T, template<class> class StopPolicy>
+PararealReport verifyParareal(const SimEnv<T>& env, const Sim<T, StopPolicy>& start, PararealConfig cfg = {})
+{
+    using Clock = std::chrono::steady_clock;
+    using Sim = Sim<T, StopPolicy>;
+    using Vec2 = Vec2<T>;
+
+    // body states: (x, y, vx, vy) per body
+    struct State { T v[3][4]; };
+
+    auto stateOf = [](const Sim& sim)
+    {
+        State s;
+        const Particle<T>* p[3] = { &sim.bodyA(), &sim.bodyB(), &sim.bodyC() };
+        for (int i = 0; i < 3; i++)
+        {
+            s.v[i][0] = p[i]->x;  s.v[i][1] = p[i]->y;
+            s.v[i][2] = p[i]->vx; s.v[i][3] = p[i]->vy;
+        }
+        return s;
+    };
+
+    auto propagate = [&stateOf](const SimEnv<T>& run_env, const State& from, int steps)
+    {
+        Vec2 pos[3], vel[3];
+        for (int i = 0; i < 3; i++)
+        {
+            pos[i] = Vec2(from.v[i][0], from.v[i][1]);
+            vel[i] = Vec2(from.v[i][2], from.v[i][3]);
+        }
+
+        Sim sim;
+        sim.setup(run_env, pos, vel);
+        for (int i = 0; i < steps; i++)
+            sim.progress(run_env);
+        return stateOf(sim);
+    };
+
+    auto maxDiff = [](const State& a, const State& b, int components)
+    {
+        using std::abs;
+        f64 d = 0;
+        for (int i = 0; i < 3; i++)
+            for (int k = 0; k < components; k++)
+                d = std::max(d, (f64)abs(a.v[i][k] - b.v[i][k]));
+        return d;
+    };
+
+    PararealReport report;
+
+    const int freq = std::max(1, env.escape_freq);
+    const int factor = std::max(1, cfg.coarse_factor);
+
+    SimEnv<T> coarse_env(env);
+    coarse_env.dt = env.dt * T(factor);
+
+    const auto t0 = Clock::now();
+
+    // span estimate: the coarse run to the stop policy's first abort. Drift
+    // checks are off for it, the coarse step drifts more by design
+    {
+        SimEnv<T> estimate_env(coarse_env);
+        estimate_env.max_iter = (env.max_iter + factor - 1) / factor;
+        estimate_env.energy_tolerance = T(0);
+        estimate_env.momentum_tolerance = T(0);
+
+        Sim estimate;
+        estimate.setup(estimate_env, start);
+        while (estimate.curIter() < estimate_env.max_iter)
+        {
+            estimate.progress(estimate_env);
+            if ((int)estimate.stability().type & (int)StopResult::ABORT_MASK)
+                break;
+        }
+        report.span_result = estimate.stability();
+        report.span_iters = std::min(env.max_iter, estimate.curIter() * factor);
+    }
+    report.estimate_ms = std::chrono::duration<f64, std::milli>(Clock::now() - t0).count();
+
+    const int total = report.span_iters;
+    if (total == 0)
+        return report;
+
+    const int hw = std::max(1, (int)std::thread::hardware_concurrency());
+    const int N = std::clamp(cfg.segments > 0 ? cfg.segments : hw, 1, std::max(1, total / freq));
+    const int max_iterations = cfg.max_iterations > 0 ? std::min(cfg.max_iterations, N) : N;
+
+    // segment n covers fine steps [first[n], first[n+1]). Inner boundaries sit
+    // on multiples of freq (segments are >= freq long), where the serial track has states
+    std::vector<int> first(N + 1);
+    for (int n = 0; n < N; n++)
+        first[n] = (int)((i64)total * n / N) / freq * freq;
+    first[N] = total;
+
+    auto coarse = [&](const State& from, int n)
+    {
+        // round the coarse step count, the coarse span only approximates the segment
+        const int steps = std::max(1, (first[n + 1] - first[n] + factor / 2) / factor);
+        return propagate(coarse_env, from, steps);
+    };
+
+    std::vector<State> U(N + 1), G_old(N), F(N);
+    U[0] = stateOf(start);
+    for (int n = 0; n < N; n++)
+    {
+        G_old[n] = coarse(U[n], n);
+        U[n + 1] = G_old[n];
+    }
+
+    std::vector<std::future<void>> tasks(N);
+    for (int k = 0; k < max_iterations; k++)
+    {
+        // fine sweep, segments before k are already exact
+        for (int n = k; n < N; n++)
+        {
+            tasks[n] = submitSimTask([&, n]() {
+                F[n] = propagate(env, U[n], first[n + 1] - first[n]);
+            });
+        }
+        for (int n = k; n < N; n++)
+            tasks[n].get();
+
+        // serial coarse correction
+        f64 update = 0;
+        State next = F[k]; // U[k] is exact, so is U[k + 1]
+        update = std::max(update, maxDiff(next, U[k + 1], 4));
+        U[k + 1] = next;
+
+        for (int n = k + 1; n < N; n++)
+        {
+            const State g = coarse(U[n], n);
+            State u;
+            for (int i = 0; i < 3; i++)
+                for (int c = 0; c < 4; c++)
+                    u.v[i][c] = g.v[i][c] + F[n].v[i][c] - G_old[n].v[i][c];
+
+            G_old[n] = g;
+            update = std::max(update, maxDiff(u, U[n + 1], 4));
+            U[n + 1] = u;
+        }
+
+        report.iterations = k + 1;
+        report.last_update = update;
+        if (update <= cfg.tolerance || k + 1 == N)
+        {
+            report.converged = true;
+            break;
+        }
+    }
+
+    report.parareal_ms = std::chrono::duration<f64, std::milli>(Clock::now() - t0).count();
+    report.segments = N;
+
+    if (cfg.compare_serial)
+    {
+        // fine serial run of the same span, its state every freq steps
+        std::vector<State> track;
+        track.reserve((size_t)(total / freq));
+
+        const auto t_serial = Clock::now();
+        Sim serial;
+        serial.setup(env, start);
+        for (int i = 1; i <= total; i++)
+        {
+            serial.progress(env);
+            if (i % freq == 0)
+                track.push_back(stateOf(serial));
+        }
+        report.serial_ms = std::chrono::duration<f64, std::milli>(Clock::now() - t_serial).count();
+
+        const State serial_end = stateOf(serial);
+        report.max_pos_err = 0;
+        for (int n = 1; n <= N; n++)
+        {
+            const State& s = (n == N) ? serial_end : track[first[n] / freq - 1];
+            report.max_pos_err = std::max(report.max_pos_err, maxDiff(s, U[n], 2));
+        }
+        report.final_pos_err = maxDiff(serial_end, U[N], 2);
+    }
+
+    return report;
+}
+
+SIM_END;
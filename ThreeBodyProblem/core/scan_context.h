@@ -0,0 +1,70 @@
+#pragma once
+#include "orbit_sim.h"
+#include <memory>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+SIM_BEG;
+
+using namespace bl;
+
+/// ─────── ScanContext ───────
+//
+// Reusable per-worker scan state: a SimGrid together with the SimEnv it
+// references, in one cache-line aligned heap block. A worker creates its
+// context once (on its own thread, so with first-touch NUMA placement the
+// pages land on the worker's node) and rebinds it to each tile's env, instead
+// of constructing a SimGrid per pixel or tile.
+
+template<class T, int VEL_GRID_DIM, template<class> class StopPolicy, bool MULTI_THREAD = false>
+struct alignas(64) ScanContext
+{
+    using Env = SimEnv<T>;
+    using Grid = SimGrid<T, VEL_GRID_DIM, StopPolicy, MULTI_THREAD>;
+
+    Env env;
+    Grid grid; // references env
+
+    explicit ScanContext(const Env& e) : env(e), grid(env) {}
+    ScanContext(const ScanContext&) = delete;
+    ScanContext& operator=(const ScanContext&) = delete;
+
+    static std::unique_ptr<ScanContext> create(const Env& e)
+    {
+        return std::make_unique<ScanContext>(e);
+    }
+
+    // the grid follows, it holds a reference to env
+    void bind(const Env& e) { env = e; }
+};
+
+/// ─────── thread affinity ───────
+
+// pin the calling thread to one CPU (cpu < 0: allow every CPU again).
+// Linux only, elsewhere it's a no-op that returns false
+inline bool pinCurrentThread(int cpu)
+{
+    #if defined(__linux__)
+    const int n = std::max(1, (int)std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpu < 0)
+    {
+        for (int i = 0; i < n; i++)
+            CPU_SET(i, &set);
+    }
+    else
+    {
+        CPU_SET(cpu % n, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+    #else
+    (void)cpu;
+    return false;
+    #endif
+}
+
+SIM_END;
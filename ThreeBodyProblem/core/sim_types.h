@@ -0,0 +1,83 @@
+#pragma once
+
+/// ─────── core base types ───────
+//
+// The simulation core (this directory) only needs a handful of bitloop basics.
+// Inside the app they come from <bitloop.h>. Standalone builds
+// (SIM_CORE_STANDALONE, e.g. the ThreeBodyCore library) get a minimal drop-in
+// set instead, declared in their own namespaces so a standalone build can be
+// linked into the same binary as bitloop without symbol clashes.
+
+#ifndef SIM_CORE_STANDALONE
+
+#include <bitloop.h>
+
+#else
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <limits>
+#include <vector>
+
+#define SIM_BEG namespace tbp {
+#define SIM_END }
+
+namespace tbp_base
+{
+    using f32 = float;
+    using f64 = double;
+    using i16 = std::int16_t;
+    using i32 = std::int32_t;
+    using i64 = std::int64_t;
+    using u8  = std::uint8_t;
+    using u16 = std::uint16_t;
+    using u32 = std::uint32_t;
+    using u64 = std::uint64_t;
+
+    template<class T> constexpr T sq(T v) { return v * v; }
+
+    template<class T>
+    struct Vec2
+    {
+        T x{}, y{};
+
+        Vec2() = default;
+        constexpr Vec2(T _x, T _y) : x(_x), y(_y) {}
+        template<class U> explicit constexpr Vec2(const Vec2<U>& r) : x(T(r.x)), y(T(r.y)) {}
+
+        void set(T _x, T _y)        { x = _x; y = _y; }
+        void set(const Vec2& r)     { x = r.x; y = r.y; }
+        T    mag2() const           { return x * x + y * y; }
+
+        static constexpr Vec2 highest() { return { std::numeric_limits<T>::max(), std::numeric_limits<T>::max() }; }
+
+        bool operator==(const Vec2& r) const { return x == r.x && y == r.y; }
+        bool operator!=(const Vec2& r) const { return !(*this == r); }
+        Vec2 operator+(const Vec2& r) const  { return { x + r.x, y + r.y }; }
+        Vec2 operator-(const Vec2& r) const  { return { x - r.x, y - r.y }; }
+        Vec2 operator*(T s) const            { return { x * s, y * s }; }
+    };
+}
+
+namespace bl = tbp_base;
+
+#endif
+
+SIM_BEG;
+
+// Runs task on a worker thread (bitloop's pool in the app, std::async standalone)
+template<class F>
+std::future<void> submitSimTask(F&& task)
+{
+    #ifdef SIM_CORE_STANDALONE
+    return std::async(std::launch::async, std::forward<F>(task));
+    #else
+    using namespace bl;
+    return Thread::pool().submit_task(std::forward<F>(task));
+    #endif
+}
+
+SIM_END;
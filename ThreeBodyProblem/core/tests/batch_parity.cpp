@@ -0,0 +1,104 @@
+// evaluateBatch() against the scalar Sim::progress() loop it replaces.
+//
+// The baseline kernel (KernelISA::SSE2) must reproduce the scalar reference
+// exactly: same stop result and iteration for every initial condition, with
+// full and partial lane chunks. With THREEBODY_DETERMINISTIC the best ISA this
+// CPU supports must match too (otherwise FMA contraction may move escapes).
+
+#include "batch.h"
+#include <cstdio>
+#include <vector>
+
+using namespace bl;
+using namespace tbp;
+
+template<class T>
+static SimOutcome reference(const SimEnv<T>& env, const InitialConditions<T>& ic)
+{
+    Sim<T> sim;
+    sim.setup(env, ic.pos, ic.vel);
+
+    for (int i = 0; i < env.max_iter; i++)
+    {
+        sim.progress(env);
+        if (i % env.escape_freq == 0 && ((int)sim.stability().type & (int)StopResult::ABORT_MASK))
+            break;
+    }
+    return { sim.stability(), sim.curIter() };
+}
+
+template<class T>
+static std::vector<InitialConditions<T>> conditions(int count)
+{
+    std::vector<InitialConditions<T>> out;
+    for (int n = 0; n < count; n++)
+    {
+        // A/B on a rough mutual orbit, C placed and kicked across bound and escaping cases
+        const T cx = T(-2) + T(4) * T(n % 7) / T(6);
+        const T cy = T(-1.5) + T(3) * T(n / 7 % 5) / T(4);
+        const T spin = T(0.3) + T(0.1) * T(n % 3);
+        const T kick = T(0.8) * T(n % 5 - 2);
+
+        InitialConditions<T> ic;
+        ic.pos[0] = Vec2<T>(T(-1), T(0));
+        ic.pos[1] = Vec2<T>(T(1), T(0));
+        ic.pos[2] = Vec2<T>(cx, cy);
+        ic.vel[0] = Vec2<T>(T(0), -spin);
+        ic.vel[1] = Vec2<T>(T(0), spin);
+        ic.vel[2] = Vec2<T>(kick, -kick);
+        out.push_back(ic);
+    }
+    return out;
+}
+
+template<class T>
+static int check(const char* label, int count)
+{
+    SimEnv<T> env(T(1), T(1), 4000, T(0.002));
+    env.soft2 = T(0.01);
+    const auto ics = conditions<T>(count);
+
+    int failures = 0;
+    #ifdef SIM_DETERMINISTIC
+    const KernelISA isas[] = { KernelISA::SSE2, bestKernelISA() };
+    #else
+    const KernelISA isas[] = { KernelISA::SSE2 };
+    #endif
+
+    for (KernelISA isa : isas)
+    {
+        std::vector<SimOutcome> outcomes(ics.size());
+        const size_t written = evaluateBatch<T>(env, ics, outcomes, isa);
+        if (written != ics.size())
+        {
+            std::printf("%s %s: wrote %zu of %zu\n", label, kernelISAName(isa), written, ics.size());
+            failures++;
+            continue;
+        }
+
+        int mismatched = 0;
+        for (size_t i = 0; i < ics.size(); i++)
+        {
+            const SimOutcome ref = reference(env, ics[i]);
+            const SimOutcome& got = outcomes[i];
+            if (got.result.type != ref.result.type || got.iters != ref.iters)
+            {
+                if (mismatched++ < 4)
+                    std::printf("%s %s: condition %zu: type %d/%d iters %d/%d\n", label, kernelISAName(isa),
+                        i, (int)got.result.type, (int)ref.result.type, got.iters, ref.iters);
+            }
+        }
+
+        std::printf("%s %s: %zu conditions, %d mismatched\n", label, kernelISAName(isa), ics.size(), mismatched);
+        failures += mismatched;
+    }
+    return failures;
+}
+
+int main()
+{
+    int failures = 0;
+    failures += check<f64>("f64", 35); // not a multiple of any lane count
+    failures += check<f32>("f32", 35);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include "core/orbit_sim.h"
+#include <array>
+#include <string>
+
+SIM_BEG;
+
+using namespace bl;
+
+/// ─────── OrbitLibrary ───────
+//
+// Deduplicated store of periodic orbits. Each orbit is reduced to a canonical
+// form shared by every copy of the same physical orbit:
+//
+//   section     states at minima of the moment of inertia (dI/dt crosses 0
+//               upwards) over one period, which removes time shifts
+//   frame       centre-of-mass relative, rotated so the first body is on +x
+//   symmetries  all 6 body permutations x reflection (y -> -y) x time
+//               reversal (v -> -v)
+//
+// The canonical key is the lexicographically smallest candidate, compared on
+// a quantised grid. Queries are matched against every candidate of the query
+// orbit, so a match is still found when a near-tie picked another candidate
+// as the key.
+//
+// Records are kept sorted by energy (a symmetry invariant), so insert-if-new
+// and nearest-match only scan a narrow energy window.
+
+struct OrbitRecord
+{
+    static constexpr int KEY_DIMS = 12; // (x, y, vx, vy) per body
+
+    f64 energy = 0;
+    f64 ang_mom = 0;     // |L| (the sign flips under reflection/time reversal)
+    f64 period = 0;      // time units
+    f64 key[KEY_DIMS]{}; // canonical state
+
+    // initial conditions, replayed with Sim::setup()
+    f64 c_pos[2]{};
+    f64 vel[3][2]{};
+    f64 G = 1, dt = 0;
+
+    u32 period_iters = 0;
+    u32 hits = 1;        // number of times this orbit was inserted
+};
+
+template<class T>
+class OrbitLibrary
+{
+public:
+
+    using SimEnv = SimEnv<T>;
+    using Vec2 = Vec2<T>;
+    using Key = std::array<f64, OrbitRecord::KEY_DIMS>;
+
+    struct Config
+    {
+        f64 key_tolerance = 0.05;    // max |delta| of any key component for a match
+        f64 energy_tolerance = 0.01; // energy window searched, relative to max(1, |E|)
+        f64 quantum = 0.01;          // grid used to order candidates
+    };
+
+    // every candidate of one orbit, candidates[best] is the canonical key
+    struct CanonicalForm
+    {
+        f64 energy = 0;
+        f64 ang_mom = 0;
+        int period_iters = 0;
+        std::vector<Key> candidates;
+        int best = -1;
+
+        bool valid() const        { return best >= 0; }
+        const Key& key() const    { return candidates[best]; }
+    };
+
+    Config config;
+
+    // integrates a copy of sim (treated as the starting configuration) until a
+    // period is detected, then builds its canonical form. false if the orbit
+    // escapes, diverges or shows no period within env.max_iter
+    template<class SimT> bool canonicalise(const SimEnv& env, const SimT& sim, CanonicalForm& out) const;
+
+    // index of the closest record within config.key_tolerance, or -1
+    int find(const CanonicalForm& form, f64* dist = nullptr) const;
+
+    // index of the closest record in the energy window (any distance), or -1
+    int nearest(const CanonicalForm& form, f64* dist = nullptr) const;
+
+    // insert-if-new, returns the record index (-1 if sim couldn't be canonicalised).
+    // For duplicates the existing record's hit count is bumped instead.
+    // canonicalise() only reads config, so callers may run it on a worker and
+    // insert the form (with makeRecord()) later
+    template<class SimT> int insert(const SimEnv& env, const SimT& sim, bool* inserted = nullptr);
+    int insert(const CanonicalForm& form, OrbitRecord record, bool* inserted = nullptr);
+
+    // initial conditions of sim (its starting configuration) under env
+    template<class SimT> static OrbitRecord makeRecord(const SimEnv& env, const SimT& sim);
+
+    // sets up sim with the record's initial conditions. false (sim untouched) if
+    // env's G or dt differ from the record's, the orbit wouldn't replay under env
+    template<class SimT> static bool restore(const SimEnv& env, const OrbitRecord& record, SimT& sim);
+    static bool replaysUnder(const SimEnv& env, const OrbitRecord& record);
+
+    void   clear()                                  { records.clear(); }
+    size_t size() const                             { return records.size(); }
+    const OrbitRecord& operator[](size_t i) const   { return records[i]; }
+
+    // binary index: LibraryHeader followed by OrbitRecord[count], sorted by energy.
+    // load() rejects files whose size doesn't match the header
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    struct LibraryHeader
+    {
+        char magic[4] = { 'T', 'B', 'O', 'L' };
+        u32  version = 1;
+        u32  record_size = sizeof(OrbitRecord);
+        u32  count = 0;
+    };
+
+private:
+
+    std::vector<OrbitRecord> records; // sorted by energy
+
+    struct State { f64 p[3][4]; }; // centre-of-mass relative (x, y, vx, vy)
+
+    template<class SimT> static State relativeState(const SimT& sim);
+    static f64  inertiaRate(const State& s); // (dI/dt) / 2
+    void addCandidates(const State& s, CanonicalForm& form) const;
+    bool keyLess(const Key& a, const Key& b) const;
+
+    static f64 distance(const OrbitRecord& record, const CanonicalForm& form);
+    int closest(const CanonicalForm& form, f64* dist, f64 max_dist) const;
+};
+
+SIM_END;
+
+#include "orbit_library.hpp"
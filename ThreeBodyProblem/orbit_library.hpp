@@ -0,0 +1,338 @@
+#include <bitloop.h>
+#include <fstream>
+#include <cstring>
+
+SIM_BEG;
+using namespace bl;
+
+template<class T> template<class SimT>
+typename OrbitLibrary<T>::State OrbitLibrary<T>::relativeState(const SimT& sim)
+{
+    const Particle<T>* body[3] = { &sim.bodyA(), &sim.bodyB(), &sim.bodyC() };
+
+    // equal masses
+    f64 com[4] = {};
+    for (int i = 0; i < 3; i++)
+    {
+        com[0] += (f64)body[i]->x;  com[1] += (f64)body[i]->y;
+        com[2] += (f64)body[i]->vx; com[3] += (f64)body[i]->vy;
+    }
+    for (f64& v : com) v /= 3.0;
+
+    State s;
+    for (int i = 0; i < 3; i++)
+    {
+        s.p[i][0] = (f64)body[i]->x - com[0];
+        s.p[i][1] = (f64)body[i]->y - com[1];
+        s.p[i][2] = (f64)body[i]->vx - com[2];
+        s.p[i][3] = (f64)body[i]->vy - com[3];
+    }
+    return s;
+}
+
+template<class T>
+f64 OrbitLibrary<T>::inertiaRate(const State& s)
+{
+    f64 r = 0;
+    for (int i = 0; i < 3; i++)
+        r += s.p[i][0] * s.p[i][2] + s.p[i][1] * s.p[i][3];
+    return r;
+}
+
+template<class T>
+bool OrbitLibrary<T>::keyLess(const Key& a, const Key& b) const
+{
+    // quantised, so rounding noise can't decide the order of near-equal candidates
+    const f64 inv_q = 1.0 / config.quantum;
+    for (int d = 0; d < OrbitRecord::KEY_DIMS; d++)
+    {
+        const i64 qa = std::llround(a[d] * inv_q);
+        const i64 qb = std::llround(b[d] * inv_q);
+        if (qa != qb) return qa < qb;
+    }
+    return false;
+}
+
+template<class T>
+void OrbitLibrary<T>::addCandidates(const State& s, CanonicalForm& form) const
+{
+    static constexpr int perms[6][3] = {
+        { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 }
+    };
+
+    for (const auto& perm : perms)
+    {
+        // rotate the first body onto +x (or the second, if the first sits on the COM)
+        int lead = perm[0];
+        if (s.p[lead][0] * s.p[lead][0] + s.p[lead][1] * s.p[lead][1] < 1e-18)
+            lead = perm[1];
+
+        const f64 angle = std::atan2(s.p[lead][1], s.p[lead][0]);
+        const f64 cs = std::cos(angle), sn = std::sin(angle);
+
+        for (int reflect = 0; reflect < 2; reflect++)
+        {
+            for (int reverse = 0; reverse < 2; reverse++)
+            {
+                const f64 fy = reflect ? -1.0 : 1.0;
+                const f64 fv = reverse ? -1.0 : 1.0;
+
+                Key key;
+                for (int i = 0; i < 3; i++)
+                {
+                    const f64* p = s.p[perm[i]];
+                    key[i * 4 + 0] = cs * p[0] + sn * p[1];
+                    key[i * 4 + 1] = (cs * p[1] - sn * p[0]) * fy;
+                    key[i * 4 + 2] = (cs * p[2] + sn * p[3]) * fv;
+                    key[i * 4 + 3] = (cs * p[3] - sn * p[2]) * fy * fv;
+                }
+
+                form.candidates.push_back(key);
+                if (form.best < 0 || keyLess(key, form.candidates[form.best]))
+                    form.best = (int)form.candidates.size() - 1;
+            }
+        }
+    }
+}
+
+template<class T> template<class SimT>
+bool OrbitLibrary<T>::canonicalise(const SimEnv& env, const SimT& sim, CanonicalForm& out) const
+{
+    out = CanonicalForm();
+    out.energy = (f64)sim.energy();
+    out.ang_mom = std::abs((f64)sim.angularMomentum());
+
+    const T vel_quantum = env.vel_tolerance > T(0) ? env.vel_tolerance : env.pos_tolerance;
+    PeriodDetector<T> detector;
+    detector.init(env.pos_tolerance, vel_quantum, 120);
+
+    struct Section { int iter; State s; };
+    std::vector<Section> sections;
+
+    constexpr f64 max_mag2 = (f64)SimEnv::max_dist * (f64)SimEnv::max_dist;
+
+    SimT s = sim;
+    State prev = relativeState(s);
+    f64 prev_rate = inertiaRate(prev);
+
+    while (s.curIter() < env.max_iter)
+    {
+        s.progress(env);
+
+        if (s.curIter() % env.escape_freq == 0)
+        {
+            if (s.diverged()) return false;
+            if ((f64)s.bodyA().mag2() > max_mag2 ||
+                (f64)s.bodyB().mag2() > max_mag2 ||
+                (f64)s.bodyC().mag2() > max_mag2)
+                return false;
+        }
+
+        const State now = relativeState(s);
+        const f64 rate = inertiaRate(now);
+        if (prev_rate < 0 && rate >= 0)
+        {
+            // minimum of I, interpolated between the two steps
+            const f64 f = prev_rate / (prev_rate - rate);
+            Section sec{ s.curIter(), {} };
+            for (int i = 0; i < 3; i++)
+                for (int d = 0; d < 4; d++)
+                    sec.s.p[i][d] = prev.p[i][d] + (now.p[i][d] - prev.p[i][d]) * f;
+            sections.push_back(sec);
+        }
+        prev = now;
+        prev_rate = rate;
+
+        if (detector.observe(s.curIter(), s.bodyA(), s.bodyB(), s.bodyC()))
+            break;
+    }
+
+    const int period = detector.periodIters();
+    if (period <= 0) return false;
+
+    // sections over the last full period (I is periodic, so there's at least one)
+    const int from = s.curIter() - period;
+    for (const Section& sec : sections)
+        if (sec.iter > from)
+            addCandidates(sec.s, out);
+
+    out.period_iters = period;
+    return out.valid();
+}
+
+template<class T>
+f64 OrbitLibrary<T>::distance(const OrbitRecord& record, const CanonicalForm& form)
+{
+    f64 best = std::numeric_limits<f64>::max();
+    for (const Key& key : form.candidates)
+    {
+        f64 d = 0;
+        for (int i = 0; i < OrbitRecord::KEY_DIMS && d < best; i++)
+            d = std::max(d, std::abs(key[i] - record.key[i]));
+        best = std::min(best, d);
+    }
+    return best;
+}
+
+template<class T>
+int OrbitLibrary<T>::closest(const CanonicalForm& form, f64* dist, f64 max_dist) const
+{
+    if (!form.valid()) return -1;
+
+    const f64 window = config.energy_tolerance * std::max(1.0, std::abs(form.energy));
+    auto it = std::lower_bound(records.begin(), records.end(), form.energy - window,
+        [](const OrbitRecord& r, f64 e) { return r.energy < e; });
+
+    int best = -1;
+    f64 best_dist = max_dist;
+    for (; it != records.end() && it->energy <= form.energy + window; ++it)
+    {
+        const f64 d = distance(*it, form);
+        if (d <= best_dist)
+        {
+            best_dist = d;
+            best = (int)(it - records.begin());
+        }
+    }
+
+    if (dist) *dist = best_dist;
+    return best;
+}
+
+template<class T>
+int OrbitLibrary<T>::find(const CanonicalForm& form, f64* dist) const
+{
+    return closest(form, dist, config.key_tolerance);
+}
+
+template<class T>
+int OrbitLibrary<T>::nearest(const CanonicalForm& form, f64* dist) const
+{
+    return closest(form, dist, std::numeric_limits<f64>::max());
+}
+
+template<class T>
+int OrbitLibrary<T>::insert(const CanonicalForm& form, OrbitRecord record, bool* inserted)
+{
+    if (inserted) *inserted = false;
+    if (!form.valid()) return -1;
+
+    const int existing = find(form);
+    if (existing >= 0)
+    {
+        records[existing].hits++;
+        return existing;
+    }
+
+    record.energy = form.energy;
+    record.ang_mom = form.ang_mom;
+    record.period_iters = (u32)form.period_iters;
+    record.period = (f64)form.period_iters * record.dt;
+    record.hits = 1;
+    for (int i = 0; i < OrbitRecord::KEY_DIMS; i++)
+        record.key[i] = form.key()[i];
+
+    auto it = std::upper_bound(records.begin(), records.end(), record.energy,
+        [](f64 e, const OrbitRecord& r) { return e < r.energy; });
+    it = records.insert(it, record);
+
+    if (inserted) *inserted = true;
+    return (int)(it - records.begin());
+}
+
+template<class T> template<class SimT>
+OrbitRecord OrbitLibrary<T>::makeRecord(const SimEnv& env, const SimT& sim)
+{
+    OrbitRecord record;
+    record.c_pos[0] = (f64)sim.bodyC().x;
+    record.c_pos[1] = (f64)sim.bodyC().y;
+    const Particle<T>* body[3] = { &sim.bodyA(), &sim.bodyB(), &sim.bodyC() };
+    for (int i = 0; i < 3; i++)
+    {
+        record.vel[i][0] = (f64)body[i]->vx;
+        record.vel[i][1] = (f64)body[i]->vy;
+    }
+    record.G = (f64)env.G;
+    record.dt = (f64)env.dt;
+    return record;
+}
+
+template<class T> template<class SimT>
+int OrbitLibrary<T>::insert(const SimEnv& env, const SimT& sim, bool* inserted)
+{
+    if (inserted) *inserted = false;
+
+    CanonicalForm form;
+    if (!canonicalise(env, sim, form))
+        return -1;
+
+    return insert(form, makeRecord(env, sim), inserted);
+}
+
+template<class T>
+bool OrbitLibrary<T>::replaysUnder(const SimEnv& env, const OrbitRecord& record)
+{
+    // stored as (f64)env.G / (f64)env.dt, so an unchanged env compares equal
+    return (f64)env.G == record.G && (f64)env.dt == record.dt;
+}
+
+template<class T> template<class SimT>
+bool OrbitLibrary<T>::restore(const SimEnv& env, const OrbitRecord& record, SimT& sim)
+{
+    if (!replaysUnder(env, record))
+        return false;
+
+    sim.setup(env,
+        Vec2((T)record.c_pos[0], (T)record.c_pos[1]),
+        Vec2((T)record.vel[0][0], (T)record.vel[0][1]),
+        Vec2((T)record.vel[1][0], (T)record.vel[1][1]),
+        Vec2((T)record.vel[2][0], (T)record.vel[2][1]));
+    return true;
+}
+
+template<class T>
+bool OrbitLibrary<T>::save(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+
+    LibraryHeader header;
+    header.count = (u32)records.size();
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)records.data(), records.size() * sizeof(OrbitRecord));
+    return (bool)out;
+}
+
+template<class T>
+bool OrbitLibrary<T>::load(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    LibraryHeader header, expected;
+    in.read((char*)&header, sizeof(header));
+    if (!in ||
+        std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+        header.version != expected.version ||
+        header.record_size != expected.record_size)
+        return false;
+
+    // the header is untrusted, size the records from what the file actually holds
+    const std::streamoff data_begin = in.tellg();
+    in.seekg(0, std::ios::end);
+    const std::streamoff data_bytes = in.tellg() - data_begin;
+    in.seekg(data_begin);
+    if (!in || data_bytes != (std::streamoff)header.count * (std::streamoff)sizeof(OrbitRecord))
+        return false;
+
+    std::vector<OrbitRecord> loaded(header.count);
+    in.read((char*)loaded.data(), loaded.size() * sizeof(OrbitRecord));
+    if (!in) return false;
+
+    std::stable_sort(loaded.begin(), loaded.end(),
+        [](const OrbitRecord& a, const OrbitRecord& b) { return a.energy < b.energy; });
+    records = std::move(loaded);
+    return true;
+}
+
+SIM_END;
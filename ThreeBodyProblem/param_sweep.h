@@ -0,0 +1,121 @@
+#pragma once
+#include "scan_service.h"
+
+SIM_BEG;
+
+using namespace bl;
+
+/// ─────── ParamSweep ───────
+//
+// Produces a stack of stability maps, one per (G, max_vel, dt, iter_lim) tuple,
+// over a fixed world region of C positions. Maps are scheduled as a background
+// client of the shared ScanService, so sweeps use every scan worker without
+// starving the interactive views, and any map that matches a view is reused.
+//
+// For stop policies that rank by survival time, the iter_lim axis costs
+// nothing: one run at the largest limit records escape iterations, and the
+// map for any smaller limit L is min(escape_iter, L).
+
+template<class T>
+struct SweepAxis
+{
+    T min{}, max{};
+    int steps = 1;
+
+    int count() const   { return std::max(1, steps); }
+    T   value(int i) const
+    {
+        if (count() == 1) return min;
+        return min + (max - min) * T(i) / T(count() - 1);
+    }
+};
+
+template<class T, int VEL_GRID_DIM, template<class> class StopPolicy>
+class ParamSweep
+{
+public:
+
+    using ScanService = ScanService<T, VEL_GRID_DIM, StopPolicy>;
+    using SimEnv = SimEnv<T>;
+    using Vec2 = Vec2<T>;
+
+    static constexpr bool iter_lim_nested = StopPolicy<T>::ranks_by_survival;
+
+    struct Config
+    {
+        // every setting that isn't swept (softening, tolerances, pre-filters...),
+        // normally the scene's env. The axes below override G, max_vel, dt, max_iter
+        SimEnv base = SimEnv(T(1), T(1), 200000, T(0.02));
+
+        SweepAxis<T>   G{ T(1), T(1), 1 };
+        SweepAxis<T>   max_vel{ T(1), T(1), 1 };
+        SweepAxis<T>   dt{ T(0.02), T(0.02), 1 };
+        SweepAxis<int> iter_lim{ 200000, 200000, 1 };
+
+        // world region of C positions, sampled at pixel centers
+        T x0 = T(-2.5), y0 = T(-2.5), x1 = T(2.5), y1 = T(2.5);
+        int width = 128, height = 128;
+    };
+
+    ~ParamSweep();
+
+    void start(const Config& cfg);
+    void cancel();
+
+    // pulls finished pixels and keeps the service fed, call regularly (e.g. each frame)
+    void poll();
+
+    bool  running() const   { return active; }
+    int   mapCount() const  { return total_maps; }
+    float progress() const  { return total_pixels ? (float)done_pixels / (float)total_pixels : 0.0f; }
+
+    // best escape iteration of pixel (x,y) in map (g, v, d, l)
+    u32 value(int g, int v, int d, int l, int x, int y) const;
+
+    // writes the volume (see SweepHeader), returns false on I/O failure
+    bool save(const std::string& path) const;
+
+    struct SweepHeader
+    {
+        char magic[4] = { 'T', 'B', 'S', 'W' };
+        u32  version = 1;
+        u32  flags = 0;           // FLAG_ITER_LIM_NESTED: data has no iter_lim axis, clamp to read
+        u32  width = 0, height = 0;
+        u32  n_G = 0, n_vel = 0, n_dt = 0, n_iter_lim = 0;
+        u32  reserved = 0;        // explicit (zeroed) padding before region
+        f64  region[4]{};         // x0, y0, x1, y1
+        // followed by: f64 G[n_G], f64 max_vel[n_vel], f64 dt[n_dt], u32 iter_lim[n_iter_lim]
+        // then u32 escape iterations [n_G][n_vel][n_dt]([n_iter_lim])[height][width]
+    };
+
+    static constexpr u32 FLAG_ITER_LIM_NESTED = 1;
+
+    // written raw, so no implicit padding may reach the file
+    static_assert(sizeof(SweepHeader) == 4 + 9 * sizeof(u32) + 4 * sizeof(f64), "SweepHeader has padding");
+
+private:
+
+    Config cfg;
+    int client = -1;
+    bool active = false;
+
+    int runs_per_map = 1; // iter_lim values integrated separately (1 when nested)
+    int total_maps = 0;
+    int total_runs = 0;   // distinct integrations actually scheduled
+    i64 total_pixels = 0;
+    i64 done_pixels = 0;
+
+    int next_tile = 0;    // next (run, row) to submit
+    int in_flight = 0;    // tiles submitted but not fully collected
+
+    std::vector<u32> volume;                      // [run][height][width]
+    std::vector<int> row_remaining;               // per (run, row)
+    std::vector<typename ScanService::PixelResult> collected;
+
+    SimEnv runEnv(int run) const;
+    void submitTiles(int max_in_flight);
+};
+
+SIM_END;
+
+#include "param_sweep.hpp"
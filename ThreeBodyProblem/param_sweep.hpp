@@ -0,0 +1,185 @@
+#include <bitloop.h>
+#include <fstream>
+
+SIM_BEG;
+using namespace bl;
+
+#define ParamSweepTmpl  template<class T, int VEL_GRID_DIM, template<class> class StopPolicy>
+#define ParamSweepID    ParamSweep<T, VEL_GRID_DIM, StopPolicy>
+
+ParamSweepTmpl ParamSweepID::~ParamSweep()
+{
+    if (client >= 0)
+        ScanService::shared().unregisterClient(client);
+}
+
+ParamSweepTmpl typename ParamSweepID::SimEnv ParamSweepID::runEnv(int run) const
+{
+    // run index = (((g * n_vel + v) * n_dt + d) * runs_per_map + l)
+    const int l = run % runs_per_map; run /= runs_per_map;
+    const int d = run % cfg.dt.count(); run /= cfg.dt.count();
+    const int v = run % cfg.max_vel.count(); run /= cfg.max_vel.count();
+    const int g = run;
+
+    const int iter_lim = iter_lim_nested ?
+        std::max(cfg.iter_lim.min, cfg.iter_lim.max) :
+        cfg.iter_lim.value(l);
+
+    SimEnv env = cfg.base;
+    env.G = cfg.G.value(g);
+    env.dt = cfg.dt.value(d);
+    env.max_iter = iter_lim;
+
+    // the velocity tolerance keeps its ratio to max_vel (SimEnv's default is max_vel / 10)
+    const T max_vel = cfg.max_vel.value(v);
+    if (env.max_vel > T(0))
+        env.vel_tolerance = env.vel_tolerance * (max_vel / env.max_vel);
+    env.max_vel = max_vel;
+    return env;
+}
+
+ParamSweepTmpl void ParamSweepID::start(const Config& config)
+{
+    ScanService& service = ScanService::shared();
+
+    if (client < 0)
+    {
+        client = service.registerClient();
+        service.setBackground(client, true);
+    }
+    else
+    {
+        service.cancel(client);
+    }
+
+    cfg = config;
+    cfg.width = std::max(1, cfg.width);
+    cfg.height = std::max(1, cfg.height);
+
+    runs_per_map = iter_lim_nested ? 1 : cfg.iter_lim.count();
+    total_maps = cfg.G.count() * cfg.max_vel.count() * cfg.dt.count() * cfg.iter_lim.count();
+    total_runs = cfg.G.count() * cfg.max_vel.count() * cfg.dt.count() * runs_per_map;
+    total_pixels = (i64)total_runs * cfg.width * cfg.height;
+    done_pixels = 0;
+
+    volume.assign((size_t)total_pixels, 0);
+    row_remaining.assign((size_t)total_runs * cfg.height, cfg.width);
+    next_tile = 0;
+    in_flight = 0;
+    active = (client >= 0);
+
+    poll();
+}
+
+ParamSweepTmpl void ParamSweepID::cancel()
+{
+    if (client >= 0)
+        ScanService::shared().cancel(client);
+    active = false;
+}
+
+ParamSweepTmpl void ParamSweepID::submitTiles(int max_in_flight)
+{
+    ScanService& service = ScanService::shared();
+    std::vector<typename ScanService::PixelRequest> tile;
+    tile.reserve(cfg.width);
+
+    const int tile_count = total_runs * cfg.height;
+    while (in_flight < max_in_flight && next_tile < tile_count)
+    {
+        // tiles are rows; the run is encoded in py so results can be routed back
+        const int run = next_tile / cfg.height;
+        const int y = next_tile % cfg.height;
+        const T wy = cfg.y0 + (cfg.y1 - cfg.y0) * (T(y) + T(0.5)) / T(cfg.height);
+
+        tile.clear();
+        for (int x = 0; x < cfg.width; x++)
+        {
+            const T wx = cfg.x0 + (cfg.x1 - cfg.x0) * (T(x) + T(0.5)) / T(cfg.width);
+            tile.push_back({ x, next_tile, Vec2(wx, wy) });
+        }
+
+        service.submit(client, runEnv(run), tile);
+        next_tile++;
+        in_flight++;
+    }
+}
+
+ParamSweepTmpl void ParamSweepID::poll()
+{
+    if (!active) return;
+
+    ScanService& service = ScanService::shared();
+
+    collected.clear();
+    service.collect(client, collected);
+
+    for (const auto& r : collected)
+    {
+        volume[(size_t)r.py * cfg.width + r.px] = (u32)r.best_iter;
+        if (--row_remaining[r.py] == 0)
+            in_flight--;
+    }
+    done_pixels += (i64)collected.size();
+
+    // enough queued work to keep every worker busy, without flooding the service
+    submitTiles(std::max(4, service.stats().workers * 4));
+
+    if (done_pixels >= total_pixels)
+        active = false;
+}
+
+ParamSweepTmpl u32 ParamSweepID::value(int g, int v, int d, int l, int x, int y) const
+{
+    const int map = (g * cfg.max_vel.count() + v) * cfg.dt.count() + d;
+    if constexpr (iter_lim_nested)
+    {
+        const u32 escape_iter = volume[((size_t)map * cfg.height + y) * cfg.width + x];
+        return std::min(escape_iter, (u32)cfg.iter_lim.value(l));
+    }
+    else
+    {
+        const size_t run = (size_t)map * runs_per_map + l;
+        return volume[(run * cfg.height + y) * cfg.width + x];
+    }
+}
+
+ParamSweepTmpl bool ParamSweepID::save(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+
+    SweepHeader header;
+    header.flags = iter_lim_nested ? FLAG_ITER_LIM_NESTED : 0;
+    header.width = cfg.width;
+    header.height = cfg.height;
+    header.n_G = cfg.G.count();
+    header.n_vel = cfg.max_vel.count();
+    header.n_dt = cfg.dt.count();
+    header.n_iter_lim = cfg.iter_lim.count();
+    header.region[0] = (f64)cfg.x0; header.region[1] = (f64)cfg.y0;
+    header.region[2] = (f64)cfg.x1; header.region[3] = (f64)cfg.y1;
+    out.write((const char*)&header, sizeof(header));
+
+    auto writeAxis = [&](const SweepAxis<T>& axis)
+    {
+        for (int i = 0; i < axis.count(); i++)
+        {
+            const f64 v = (f64)axis.value(i);
+            out.write((const char*)&v, sizeof(v));
+        }
+    };
+    writeAxis(cfg.G);
+    writeAxis(cfg.max_vel);
+    writeAxis(cfg.dt);
+    for (int i = 0; i < cfg.iter_lim.count(); i++)
+    {
+        const u32 v = (u32)cfg.iter_lim.value(i);
+        out.write((const char*)&v, sizeof(v));
+    }
+
+    out.write((const char*)volume.data(), volume.size() * sizeof(u32));
+    return (bool)out;
+}
+
+SIM_END;
@@ -0,0 +1,104 @@
+#pragma once
+#include "core/orbit_sim.h"
+#include "core/double_double.h"
+#include <chrono>
+
+SIM_BEG;
+
+using namespace bl;
+
+/// ─────── precision check ───────
+//
+// Re-runs a starting configuration in its own float type (the "base", e.g.
+// f64) and in double-double, and compares them: both outcomes, the first check
+// where the base trajectory leaves the double-double one by more than
+// env.pos_tolerance (from there on, base rounding decides the outcome), and
+// what the extra precision costs.
+
+struct PrecisionReport
+{
+    StopResult base_result, dd_result;
+    int base_iters = 0, dd_iters = 0;
+    int split_iter = -1;     // -1 = trajectories never separated
+    f64 max_pos_err = 0;     // largest base vs double-double position difference
+    f64 base_ms = 0, dd_ms = 0;
+
+    bool agrees() const    { return base_result.type == dd_result.type; }
+    f64  costRatio() const { return (base_ms > 0) ? (dd_ms / base_ms) : 0.0; }
+};
+
+template<class T, template<class> class StopPolicy>
+PrecisionReport checkPrecision(const SimEnv<T>& env, const Sim<T, StopPolicy>& start)
+{
+    using Clock = std::chrono::steady_clock;
+
+    PrecisionReport report;
+    std::vector<f64> track; // base positions at every check (a.x, a.y, b.x, b.y, c.x, c.y)
+    track.reserve((size_t)(env.max_iter / env.escape_freq + 1) * 6);
+
+    // run to the first abort (or env.max_iter), calling onCheck every escape_freq
+    auto run = [](const auto& run_env, auto& sim, auto&& onCheck) -> StopResult
+    {
+        while (sim.curIter() < run_env.max_iter)
+        {
+            sim.progress(run_env);
+            if (sim.curIter() % run_env.escape_freq != 0)
+                continue;
+
+            onCheck(sim);
+            const StopResult result = sim.stability();
+            if ((int)result.type & (int)StopResult::ABORT_MASK)
+                return result;
+        }
+        return sim.stability();
+    };
+
+    {
+        Sim<T, StopPolicy> sim;
+        sim.setup(env, start);
+
+        const auto t0 = Clock::now();
+        report.base_result = run(env, sim, [&](const Sim<T, StopPolicy>& s)
+        {
+            const Vec2<T> p[3] = { s.particleA(), s.particleB(), s.particleC() };
+            for (const Vec2<T>& v : p)
+            {
+                track.push_back((f64)v.x);
+                track.push_back((f64)v.y);
+            }
+        });
+        report.base_ms = std::chrono::duration<f64, std::milli>(Clock::now() - t0).count();
+        report.base_iters = sim.curIter();
+    }
+
+    {
+        const SimEnv<ddouble> dd_env(env);
+        Sim<ddouble, StopPolicy> sim;
+        sim.setup(dd_env, start);
+
+        size_t k = 0;
+        const auto t0 = Clock::now();
+        report.dd_result = run(dd_env, sim, [&](const Sim<ddouble, StopPolicy>& s)
+        {
+            if (k + 6 > track.size()) return;
+
+            const Vec2<ddouble> p[3] = { s.particleA(), s.particleB(), s.particleC() };
+            f64 err = 0;
+            for (const Vec2<ddouble>& v : p)
+            {
+                err = std::max(err, std::abs((f64)v.x - track[k++]));
+                err = std::max(err, std::abs((f64)v.y - track[k++]));
+            }
+
+            report.max_pos_err = std::max(report.max_pos_err, err);
+            if (report.split_iter < 0 && err > (f64)env.pos_tolerance)
+                report.split_iter = s.curIter();
+        });
+        report.dd_ms = std::chrono::duration<f64, std::milli>(Clock::now() - t0).count();
+        report.dd_iters = sim.curIter();
+    }
+
+    return report;
+}
+
+SIM_END;
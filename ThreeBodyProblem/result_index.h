@@ -0,0 +1,72 @@
+#pragma once
+#include "core/orbit_sim.h"
+#include <unordered_map>
+
+SIM_BEG;
+
+using namespace bl;
+
+/// ─────── ResultIndex ───────
+//
+// Spatial index of finished scan pixels (best configuration per C position),
+// so hover/click can show a precomputed result instead of running a SimGrid.
+//
+// Each entry covers its pixel's footprint (a square of half-width radius).
+// Entries are hashed into uniform grids, one level per power-of-two cell size
+// with cell >= 2 * radius, so scans at any zoom can share the index and a
+// lookup only probes the 3x3 cells around the query on each populated level.
+// Finer levels are tried first (the closest zoom answers).
+
+template<class T>
+class ResultIndex
+{
+public:
+
+    using Vec2 = Vec2<T>;
+
+    struct Entry
+    {
+        Vec2 pos;       // pixel center
+        T    radius;    // half-width of the pixel footprint
+        StopResult best;
+        int  best_sim;
+        int  best_iter;
+    };
+
+    static constexpr size_t max_entries = 1 << 20; // cleared beyond this
+
+    // results are only valid for one sim configuration, a new key clears the index
+    void setEnvKey(u64 key);
+    u64  envKey() const { return env_key; }
+
+    // adds (or replaces, for the same pixel center) a result
+    void insert(const Entry& entry);
+
+    // closest entry whose footprint contains pos, or nullptr
+    const Entry* find(Vec2 pos) const;
+
+    void   clear();
+    size_t size() const { return entries.size(); }
+
+private:
+
+    struct Level
+    {
+        int exponent;   // cell size = 2^exponent
+        T   cell;
+        std::unordered_map<u64, std::vector<u32>> cells;
+    };
+
+    u64 env_key = 0;
+    std::vector<Entry> entries;
+    std::vector<Level> levels; // sorted fine -> coarse
+
+    static u64 cellKey(i64 cx, i64 cy) { return ((u64)(u32)cx << 32) | (u64)(u32)cy; }
+    static i64 cellCoord(T v, T cell)  { return (i64)std::floor(v / cell); }
+
+    Level& levelFor(T radius);
+};
+
+SIM_END;
+
+#include "result_index.hpp"
@@ -0,0 +1,109 @@
+#include <bitloop.h>
+
+SIM_BEG;
+using namespace bl;
+
+template<class T>
+void ResultIndex<T>::setEnvKey(u64 key)
+{
+    if (key != env_key)
+    {
+        clear();
+        env_key = key;
+    }
+}
+
+template<class T>
+void ResultIndex<T>::clear()
+{
+    entries.clear();
+    levels.clear();
+}
+
+template<class T>
+typename ResultIndex<T>::Level& ResultIndex<T>::levelFor(T radius)
+{
+    int exponent;
+    std::frexp((f64)radius * 2.0, &exponent); // 2 * radius <= 2^exponent
+
+    auto it = std::lower_bound(levels.begin(), levels.end(), exponent,
+        [](const Level& l, int e) { return l.exponent < e; });
+
+    if (it == levels.end() || it->exponent != exponent)
+        it = levels.insert(it, Level{ exponent, T(std::ldexp(1.0, exponent)), {} });
+
+    return *it;
+}
+
+template<class T>
+void ResultIndex<T>::insert(const Entry& entry)
+{
+    if (!(entry.radius > T(0)))
+        return;
+
+    if (entries.size() >= max_entries)
+        clear();
+
+    Level& level = levelFor(entry.radius);
+    std::vector<u32>& bucket = level.cells[cellKey(
+        cellCoord(entry.pos.x, level.cell),
+        cellCoord(entry.pos.y, level.cell))];
+
+    // same pixel scanned again (e.g. a rescan of this view)
+    for (u32 i : bucket)
+    {
+        if (entries[i].pos == entry.pos)
+        {
+            entries[i] = entry;
+            return;
+        }
+    }
+
+    bucket.push_back((u32)entries.size());
+    entries.push_back(entry);
+}
+
+template<class T>
+const typename ResultIndex<T>::Entry* ResultIndex<T>::find(Vec2 pos) const
+{
+    for (const Level& level : levels)
+    {
+        const i64 cx = cellCoord(pos.x, level.cell);
+        const i64 cy = cellCoord(pos.y, level.cell);
+
+        const Entry* best = nullptr;
+        T best_d2 = std::numeric_limits<T>::max();
+
+        for (i64 y = cy - 1; y <= cy + 1; y++)
+        {
+            for (i64 x = cx - 1; x <= cx + 1; x++)
+            {
+                auto it = level.cells.find(cellKey(x, y));
+                if (it == level.cells.end())
+                    continue;
+
+                for (u32 i : it->second)
+                {
+                    const Entry& e = entries[i];
+                    const T dx = pos.x - e.pos.x;
+                    const T dy = pos.y - e.pos.y;
+                    if (std::abs(dx) > e.radius || std::abs(dy) > e.radius)
+                        continue;
+
+                    const T d2 = dx * dx + dy * dy;
+                    if (d2 < best_d2)
+                    {
+                        best_d2 = d2;
+                        best = &e;
+                    }
+                }
+            }
+        }
+
+        if (best)
+            return best;
+    }
+    return nullptr;
+}
+
+SIM_END;
@@ -0,0 +1,204 @@
+#pragma once
+#include "core/orbit_sim.h"
+#include "core/scan_context.h"
+#include "core/alloc_counter.h"
+#include <condition_variable>
+#include <unordered_map>
+#include <thread>
+
+SIM_BEG;
+
+using namespace bl;
+
+/// ─────── ScanService ───────
+//
+// One scan scheduler shared by every scene with the same sim configuration.
+// Scenes (clients) submit tiles of pixels; a dedicated worker pool always
+// picks the highest-priority tile:
+//
+//   focused client   > other clients
+//   on-screen tiles  > off-screen tiles
+//   interactive      > background (e.g. parameter sweeps)
+//   older tiles      > newer tiles
+//
+// Pixels are deduplicated on (SimEnv, world position): a pixel already queued,
+// running or finished for any client is never integrated twice, its result is
+// fanned out to every subscriber instead.
+//
+// Each worker owns a ScanContext (allocated on its own thread) that it reuses
+// for every pixel, so integrating a pixel allocates nothing. Worker telemetry
+// lives in per-worker, cache-line aligned atomics (no lock, no false sharing),
+// and workers can optionally be pinned to CPUs.
+
+template<class T, int VEL_GRID_DIM, template<class> class StopPolicy>
+class ScanService
+{
+public:
+
+    using Env = SimEnv<T>;
+    using Vec = Vec2<T>;
+    using Context = ScanContext<T, VEL_GRID_DIM, StopPolicy, false>;
+    using Grid = typename Context::Grid;
+
+    static constexpr int MAX_CLIENTS = 64;
+
+    struct PixelRequest
+    {
+        int px, py;
+        Vec pos;
+    };
+
+    struct PixelResult
+    {
+        int px, py;
+        Vec pos;
+        StopResult best;
+        int best_sim;
+        int best_iter;
+    };
+
+    struct Stats
+    {
+        int workers = 0;
+        int pending_tiles = 0;
+        u64 computed = 0;  // pixels integrated
+        u64 dedup_hits = 0; // pixels served from another request/cache
+        u64 diverged = 0;   // sims aborted for conservation drift
+        u64 ruled_out = 0;  // sims removed by the analytic pre-filter
+        u64 fast_tracked = 0; // sims skipped once a fast-track candidate lasted the run
+
+        int contexts = 0;        // per-worker scan contexts allocated so far
+        u64 context_bytes = 0;
+        int pinned_workers = 0;
+        u64 pixel_allocations = 0; // heap allocations while integrating pixels (needs AllocCounter)
+        u64 pixel_atomics = 0;     // atomic read-modify-writes by the workers (locks, telemetry flushes, allocation counting)
+    };
+
+    static ScanService& shared()
+    {
+        static ScanService service;
+        return service;
+    }
+
+    ~ScanService();
+
+    int  registerClient();
+    void unregisterClient(int client);
+
+    // priority hints
+    void setFocus(int client);
+    void setVisibleRect(int client, T x0, T y0, T x1, T y1);
+    void setBackground(int client, bool background); // only runs when nothing else is queued
+
+    // pin worker i to CPU i + 1 (CPU 0 is left to the scene/UI), applied as
+    // workers pick up their next tile. Linux only
+    void setPinWorkers(bool pin) { pin_workers.store(pin, std::memory_order_relaxed); }
+
+    // queue a tile of pixels for client (results arrive through collect())
+    void submit(int client, const Env& env, const std::vector<PixelRequest>& pixels);
+
+    // drop everything still queued for client (finished results are kept cached)
+    void cancel(int client);
+
+    // moves finished results for client into out, returns number appended
+    size_t collect(int client, std::vector<PixelResult>& out);
+
+    Stats stats() const;
+
+    // hash of every SimEnv field that affects a pixel's outcome
+    static u64 envKey(const Env& env);
+
+private:
+
+    struct PixelKey
+    {
+        u64 env_key;
+        u64 pos_key;
+        bool operator==(const PixelKey& r) const { return env_key == r.env_key && pos_key == r.pos_key; }
+    };
+
+    struct PixelKeyHash
+    {
+        size_t operator()(const PixelKey& k) const { return (size_t)(k.env_key ^ (k.pos_key * 0x9E3779B97F4A7C15ull)); }
+    };
+
+    struct Subscriber { int client, px, py; };
+
+    struct Entry
+    {
+        bool done = false;
+        u64 tile_seq = 0;
+        PixelResult result{};
+        std::vector<Subscriber> subscribers;
+    };
+
+    struct Tile
+    {
+        Env env;
+        u64 env_key = 0;
+        std::vector<PixelRequest> pixels{};
+        T x0{}, y0{}, x1{}, y1{}; // world bounds of pixels
+        u64 clients = 0;  // bitmask of clients waiting on this tile
+        u64 seq = 0;
+        int priority = 0;
+    };
+
+    struct Client
+    {
+        bool used = false;
+        bool background = false;
+        bool has_rect = false;
+        T x0{}, y0{}, x1{}, y1{};
+        std::vector<PixelResult> outbox;
+    };
+
+    // written by its own worker only (plain relaxed stores of its running
+    // totals, no read-modify-writes), read by stats()
+    struct alignas(64) Worker
+    {
+        std::thread thread;
+        std::atomic<u64> computed{ 0 };
+        std::atomic<u64> diverged{ 0 };
+        std::atomic<u64> ruled_out{ 0 };
+        std::atomic<u64> fast_tracked{ 0 };
+        std::atomic<u64> pixel_allocations{ 0 };
+        std::atomic<u64> pixel_atomics{ 0 };
+        std::atomic<bool> has_context{ false };
+        std::atomic<bool> pinned{ false };
+    };
+
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> pin_workers{ false };
+    bool stopping = false;
+
+    std::vector<Tile> queue; // max-heap on (priority, -seq)
+    std::unordered_map<PixelKey, Entry, PixelKeyHash> entries;
+    Client clients[MAX_CLIENTS];
+    int focused = -1;
+    u64 next_seq = 0;
+
+    u64 dedup_hits = 0;
+
+    static constexpr size_t max_cached_entries = 1 << 20;
+
+    ScanService();
+
+    static u64 posKey(Vec pos);
+
+    int  tilePriority(const Tile& tile) const;
+    void rebuildQueue();
+    void deliver(const Entry& entry);
+    void workerLoop(int index);
+
+    static bool tileLess(const Tile& a, const Tile& b)
+    {
+        if (a.priority != b.priority) return a.priority < b.priority;
+        return a.seq > b.seq;
+    }
+};
+
+SIM_END;
+
+#include "scan_service.hpp"
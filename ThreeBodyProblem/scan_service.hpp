@@ -0,0 +1,409 @@
+#include <cstring>
+
+SIM_BEG;
+using namespace bl;
+
+#define ScanServiceTmpl  template<class T, int VEL_GRID_DIM, template<class> class StopPolicy>
+#define ScanServiceID    ScanService<T, VEL_GRID_DIM, StopPolicy>
+
+ScanServiceTmpl ScanServiceID::ScanService()
+{
+    // leave a core for the scene/UI threads
+    const int n = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    for (int i = 0; i < n; i++)
+        workers.push_back(std::make_unique<Worker>());
+    for (int i = 0; i < n; i++)
+        workers[i]->thread = std::thread([this, i]() { workerLoop(i); });
+}
+
+ScanServiceTmpl ScanServiceID::~ScanService()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& w : workers)
+        w->thread.join();
+}
+
+ScanServiceTmpl u64 ScanServiceID::envKey(const Env& env)
+{
+    // FNV-1a over every field that affects a pixel's outcome
+    u64 h = 0xcbf29ce484222325ull;
+    auto mix = [&h](const void* p, size_t n)
+    {
+        const u8* b = (const u8*)p;
+        for (size_t i = 0; i < n; i++) { h ^= b[i]; h *= 0x100000001b3ull; }
+    };
+    mix(&env.escape_freq, sizeof(env.escape_freq));
+    mix(&env.max_iter, sizeof(env.max_iter));
+    mix(&env.max_vel, sizeof(env.max_vel));
+    mix(&env.dt, sizeof(env.dt));
+    mix(&env.G, sizeof(env.G));
+    mix(&env.soft2, sizeof(env.soft2));
+    mix(&env.pos_tolerance, sizeof(env.pos_tolerance));
+    mix(&env.vel_tolerance, sizeof(env.vel_tolerance));
+    mix(&env.energy_tolerance, sizeof(env.energy_tolerance));
+    mix(&env.momentum_tolerance, sizeof(env.momentum_tolerance));
+    mix(&env.prefilter_unbound, sizeof(env.prefilter_unbound));
+    mix(&env.prefilter_hierarchical, sizeof(env.prefilter_hierarchical));
+    return h;
+}
+
+ScanServiceTmpl u64 ScanServiceID::posKey(Vec pos)
+{
+    // exact bit pattern of the position (as f64 so any T hashes the same way)
+    const f64 x = (f64)pos.x, y = (f64)pos.y;
+    u64 bx, by;
+    std::memcpy(&bx, &x, sizeof(bx));
+    std::memcpy(&by, &y, sizeof(by));
+    return bx ^ (by * 0xff51afd7ed558ccdull + (bx >> 17));
+}
+
+ScanServiceTmpl int ScanServiceID::registerClient()
+{
+    std::lock_guard lock(mutex);
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (clients[i].used) continue;
+        clients[i] = Client();
+        clients[i].used = true;
+        return i;
+    }
+    return -1;
+}
+
+ScanServiceTmpl void ScanServiceID::unregisterClient(int client)
+{
+    if (client < 0) return;
+    cancel(client);
+
+    std::lock_guard lock(mutex);
+    clients[client] = Client();
+    if (focused == client)
+        focused = -1;
+}
+
+ScanServiceTmpl void ScanServiceID::setFocus(int client)
+{
+    std::lock_guard lock(mutex);
+    if (focused == client) return;
+    focused = client;
+    rebuildQueue();
+}
+
+ScanServiceTmpl void ScanServiceID::setVisibleRect(int client, T x0, T y0, T x1, T y1)
+{
+    if (client < 0) return;
+
+    std::lock_guard lock(mutex);
+    Client& c = clients[client];
+    if (c.has_rect && c.x0 == x0 && c.y0 == y0 && c.x1 == x1 && c.y1 == y1)
+        return;
+
+    c.has_rect = true;
+    c.x0 = x0; c.y0 = y0;
+    c.x1 = x1; c.y1 = y1;
+    rebuildQueue();
+}
+
+ScanServiceTmpl void ScanServiceID::setBackground(int client, bool background)
+{
+    if (client < 0) return;
+
+    std::lock_guard lock(mutex);
+    clients[client].background = background;
+    rebuildQueue();
+}
+
+ScanServiceTmpl int ScanServiceID::tilePriority(const Tile& tile) const
+{
+    int best = -1;
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (!(tile.clients & (1ull << i))) continue;
+
+        const Client& c = clients[i];
+        if (c.background)
+        {
+            best = std::max(best, -1);
+            continue;
+        }
+
+        int p = (i == focused) ? 2 : 0;
+        if (!c.has_rect || (tile.x1 >= c.x0 && tile.x0 <= c.x1 && tile.y1 >= c.y0 && tile.y0 <= c.y1))
+            p += 1;
+
+        best = std::max(best, p);
+    }
+    return best;
+}
+
+ScanServiceTmpl void ScanServiceID::rebuildQueue()
+{
+    for (Tile& tile : queue)
+        tile.priority = tilePriority(tile);
+    std::make_heap(queue.begin(), queue.end(), tileLess);
+}
+
+ScanServiceTmpl void ScanServiceID::submit(int client, const Env& env, const std::vector<PixelRequest>& pixels)
+{
+    if (client < 0 || pixels.empty()) return;
+
+    Tile tile{ env };
+    tile.env_key = envKey(env);
+    tile.clients = 1ull << client;
+    tile.x0 = tile.y0 = std::numeric_limits<T>::max();
+    tile.x1 = tile.y1 = std::numeric_limits<T>::lowest();
+
+    std::unique_lock lock(mutex);
+
+    tile.seq = next_seq++;
+    std::vector<u64> lifted; // queued tiles this client now also waits on
+
+    for (const PixelRequest& req : pixels)
+    {
+        const PixelKey key{ tile.env_key, posKey(req.pos) };
+        auto [it, inserted] = entries.try_emplace(key);
+        Entry& entry = it->second;
+
+        if (!inserted)
+        {
+            dedup_hits++;
+            if (entry.done)
+            {
+                PixelResult r = entry.result;
+                r.px = req.px;
+                r.py = req.py;
+                clients[client].outbox.push_back(r);
+                continue;
+            }
+
+            // already queued/running elsewhere, wait for it
+            entry.subscribers.push_back({ client, req.px, req.py });
+            if (lifted.empty() || lifted.back() != entry.tile_seq)
+                lifted.push_back(entry.tile_seq);
+            continue;
+        }
+
+        entry.tile_seq = tile.seq;
+        entry.subscribers.push_back({ client, req.px, req.py });
+        tile.pixels.push_back(req);
+        tile.x0 = std::min(tile.x0, req.pos.x); tile.x1 = std::max(tile.x1, req.pos.x);
+        tile.y0 = std::min(tile.y0, req.pos.y); tile.y1 = std::max(tile.y1, req.pos.y);
+    }
+
+    if (!lifted.empty())
+    {
+        // the waiting client's priority now counts for those tiles too
+        for (Tile& queued : queue)
+            if (std::find(lifted.begin(), lifted.end(), queued.seq) != lifted.end())
+                queued.clients |= tile.clients;
+        rebuildQueue();
+    }
+
+    if (tile.pixels.empty())
+        return;
+
+    tile.priority = tilePriority(tile);
+    queue.push_back(std::move(tile));
+    std::push_heap(queue.begin(), queue.end(), tileLess);
+
+    lock.unlock();
+    cv.notify_one();
+}
+
+ScanServiceTmpl void ScanServiceID::cancel(int client)
+{
+    if (client < 0) return;
+
+    std::lock_guard lock(mutex);
+    const u64 bit = 1ull << client;
+
+    for (auto it = entries.begin(); it != entries.end(); )
+    {
+        auto& subs = it->second.subscribers;
+        subs.erase(std::remove_if(subs.begin(), subs.end(),
+            [client](const Subscriber& s) { return s.client == client; }), subs.end());
+
+        // forget unfinished pixels nobody is waiting for (workers skip them)
+        if (!it->second.done && subs.empty())
+            it = entries.erase(it);
+        else
+            ++it;
+    }
+
+    for (Tile& tile : queue)
+        tile.clients &= ~bit;
+
+    queue.erase(std::remove_if(queue.begin(), queue.end(),
+        [](const Tile& t) { return t.clients == 0; }), queue.end());
+    rebuildQueue();
+
+    clients[client].outbox.clear();
+}
+
+ScanServiceTmpl size_t ScanServiceID::collect(int client, std::vector<PixelResult>& out)
+{
+    if (client < 0) return 0;
+
+    std::lock_guard lock(mutex);
+    auto& outbox = clients[client].outbox;
+    const size_t n = outbox.size();
+    out.insert(out.end(), outbox.begin(), outbox.end());
+    outbox.clear();
+    return n;
+}
+
+ScanServiceTmpl typename ScanServiceID::Stats ScanServiceID::stats() const
+{
+    std::lock_guard lock(mutex);
+    Stats s;
+    s.workers = (int)workers.size();
+    s.pending_tiles = (int)queue.size();
+    s.dedup_hits = dedup_hits;
+
+    for (const auto& w : workers)
+    {
+        s.computed += w->computed.load(std::memory_order_relaxed);
+        s.diverged += w->diverged.load(std::memory_order_relaxed);
+        s.ruled_out += w->ruled_out.load(std::memory_order_relaxed);
+        s.fast_tracked += w->fast_tracked.load(std::memory_order_relaxed);
+        s.pixel_allocations += w->pixel_allocations.load(std::memory_order_relaxed);
+        s.pixel_atomics += w->pixel_atomics.load(std::memory_order_relaxed);
+        s.contexts += w->has_context.load(std::memory_order_relaxed) ? 1 : 0;
+        s.pinned_workers += w->pinned.load(std::memory_order_relaxed) ? 1 : 0;
+    }
+    s.context_bytes = (u64)s.contexts * sizeof(Context);
+    return s;
+}
+
+ScanServiceTmpl void ScanServiceID::deliver(const Entry& entry)
+{
+    for (const Subscriber& s : entry.subscribers)
+    {
+        PixelResult r = entry.result;
+        r.px = s.px;
+        r.py = s.py;
+        clients[s.client].outbox.push_back(r);
+    }
+}
+
+ScanServiceTmpl void ScanServiceID::workerLoop(int index)
+{
+    Worker& w = *workers[index];
+
+    // created on the first tile, by this thread (first-touch placement)
+    std::unique_ptr<Context> context;
+
+    // kernel telemetry stays in this thread's tally until the tile is done
+    KernelTelemetryDeferral deferral;
+
+    // running totals, published to w with relaxed stores after each pixel.
+    // pixel_atomics counts the read-modify-writes this thread performs: a
+    // mutex lock and unlock are one each (uncontended), plus the telemetry
+    // flushes and, with AllocCounter enabled, its per-allocation counters
+    constexpr u64 lock_atomics = 2;
+    u64 computed = 0, diverged = 0, ruled_out = 0, fast_tracked = 0;
+    u64 pixel_allocations = 0, pixel_atomics = 0;
+
+    while (true)
+    {
+        std::unique_lock lock(mutex);
+        cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if (stopping) return;
+
+        std::pop_heap(queue.begin(), queue.end(), tileLess);
+        Tile tile = std::move(queue.back());
+        queue.pop_back();
+        lock.unlock();
+        pixel_atomics += lock_atomics;
+
+        const bool pin = pin_workers.load(std::memory_order_relaxed);
+        if (pin != w.pinned.load(std::memory_order_relaxed))
+        {
+            const bool ok = pinCurrentThread(pin ? index + 1 : -1);
+            w.pinned.store(pin && ok, std::memory_order_relaxed);
+        }
+
+        if (!context)
+        {
+            context = Context::create(tile.env);
+            w.has_context.store(true, std::memory_order_relaxed);
+        }
+        else
+        {
+            context->bind(tile.env);
+        }
+        Grid& grid = context->grid;
+
+        for (const PixelRequest& req : tile.pixels)
+        {
+            const PixelKey key{ tile.env_key, posKey(req.pos) };
+
+            {
+                // skip pixels cancelled while the tile was waiting/running
+                pixel_atomics += lock_atomics;
+                std::lock_guard guard(mutex);
+                if (entries.find(key) == entries.end())
+                    continue;
+            }
+
+            const u64 allocs_before = AllocCounter::thisThread();
+            grid.setup(req.pos);
+            grid.run();
+            const u64 allocs = AllocCounter::thisThread() - allocs_before;
+            pixel_allocations += allocs;
+            if constexpr (AllocCounter::enabled())
+                pixel_atomics += allocs * AllocCounter::atomics_per_record;
+
+            // the result lock below
+            pixel_atomics += lock_atomics;
+
+            computed++;
+            diverged += grid.diverged_count;
+            ruled_out += grid.ruled_out_count;
+            fast_tracked += grid.fast_tracked_count;
+            w.computed.store(computed, std::memory_order_relaxed);
+            w.diverged.store(diverged, std::memory_order_relaxed);
+            w.ruled_out.store(ruled_out, std::memory_order_relaxed);
+            w.fast_tracked.store(fast_tracked, std::memory_order_relaxed);
+            w.pixel_allocations.store(pixel_allocations, std::memory_order_relaxed);
+            w.pixel_atomics.store(pixel_atomics, std::memory_order_relaxed);
+
+            PixelResult result;
+            result.px = req.px;
+            result.py = req.py;
+            result.pos = req.pos;
+            result.best = grid.bestStability();
+            result.best_sim = grid.best_sim;
+            result.best_iter = grid.bestIter();
+
+            std::lock_guard guard(mutex);
+
+            auto it = entries.find(key);
+            if (it == entries.end())
+                continue;
+
+            Entry& entry = it->second;
+            entry.done = true;
+            entry.result = result;
+            deliver(entry);
+            entry.subscribers.clear();
+
+            if (entries.size() > max_cached_entries)
+            {
+                // drop finished results, keep anything still in flight
+                for (auto e = entries.begin(); e != entries.end(); )
+                    e = e->second.done ? entries.erase(e) : std::next(e);
+            }
+        }
+
+        // one telemetry flush per tile, not three shared atomics per kernel batch
+        pixel_atomics += kernelTelemetry().flush();
+        w.pixel_atomics.store(pixel_atomics, std::memory_order_relaxed);
+    }
+}
+
+SIM_END;
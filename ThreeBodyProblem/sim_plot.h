@@ -0,0 +1,46 @@
+#pragma once
+#include "core/orbit_sim.h"
+
+SIM_BEG;
+
+using namespace bl;
+
+// Recorded body paths of a sim, drawn by the scene (the bitloop-facing half of
+// the sim; the core in core/ has no drawing dependencies). Works for any sim
+// exposing bodyCount()/particle(i): Sim and NBodySim
+
+template<class T>
+class SimPlot
+{
+    using Vec2 = Vec2<T>;
+
+    std::vector<std::vector<Vec2>> paths; // one per body
+    f64 path_alpha = 0.08;
+    int fade_step = 10;
+
+    void drawPath(Viewport* ctx, const std::vector<Vec2>& path, Color col, int cur_iter, double path_w, double trail_w) const;
+
+public:
+
+    static constexpr int stride = 1;
+
+    void clear();
+    template<class SimT> void recordPositions(const SimT& sim);
+    int  bodyCount() const { return (int)paths.size(); }
+
+    // red, green, yellow for a three-body sim, then a repeating palette
+    static Color bodyColor(int i);
+    void draw(Viewport* ctx, int cur_iter = -1, double path_w=2.0, double trail_w=6.0) const;
+
+    void setFullPathAlpha(f64 alpha) { path_alpha = alpha; }
+    void setFadeStepIters(int iters) { fade_step = iters; }
+
+    // plots a copy of start (treated as starting configuration), optionally
+    // recording keyframes along the way. Returns the last iteration plotted
+    template<class SimT>
+    int plot(const SimEnv<T>& env, const SimT& start, SimKeyframes<SimT>* keyframes = nullptr);
+};
+
+SIM_END;
+
+#include "sim_plot.hpp"
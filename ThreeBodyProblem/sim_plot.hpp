@@ -0,0 +1,122 @@
+#include <bitloop.h>
+
+SIM_BEG;
+using namespace bl;
+
+template<class T>
+void SimPlot<T>::clear()
+{
+    paths.clear();
+}
+
+template<class T> template<class SimT>
+void SimPlot<T>::recordPositions(const SimT& sim)
+{
+    paths.resize(sim.bodyCount());
+    for (int i = 0; i < sim.bodyCount(); i++)
+        paths[i].push_back(sim.particle(i));
+}
+
+template<class T>
+Color SimPlot<T>::bodyColor(int i)
+{
+    switch (i)
+    {
+    case 0: return Color::red;
+    case 1: return Color::green;
+    case 2: return Color::yellow;
+    }
+
+    static const Color palette[] = {
+        Color(80, 200, 255), Color(255, 100, 255), Color(255, 160, 60),
+        Color(160, 255, 160), Color(200, 180, 255), Color(255, 255, 255)
+    };
+    return palette[(i - 3) % (int)std::size(palette)];
+}
+
+template<class T>
+void SimPlot<T>::drawPath(Viewport* ctx, const std::vector<Vec2>& path, Color col, int cur_iter, double path_w, double trail_w) const
+{
+    if (path.size() < 2) return;
+
+    bool draw_full_path = (cur_iter >= 0);
+
+    // account for fewer path data points than actual iterations
+    cur_iter /= stride;
+
+    const Color main_color(col.r, col.g, col.b, (int)(path_alpha * 255.0f));
+    ctx->setLineWidth(path_w);
+    ctx->setStrokeStyle(main_color);
+    if (draw_full_path)
+        ctx->strokePath(path, 0, std::min((size_t)cur_iter, path.size()));
+    else
+        ctx->strokePath(path);
+
+    constexpr int trail = 75;
+    if (cur_iter > 1)
+    {
+        auto comp = ctx->scopedComposite(CompositeOperation::LIGHTER);
+        auto drawTrail = [&](f64 max_w, f32 layer_alpha)
+        {
+            //constexpr int fade_step = 10;
+
+            int i0 = std::max(1, cur_iter - trail);
+            int i1 = std::min((int)path.size(), cur_iter);
+            f64 fi0 = (f64)i0;
+            f64 fi1 = (f64)i1;
+            f64 add_w = max_w - path_w;
+            f64 path_alpha = layer_alpha / (f64)(trail / fade_step);
+
+            for (int i = i0; i < i1; i += fade_step)
+            {
+                f64 f = math::lerpFactor((f64)i, fi0, fi1);
+                Color color(col.r, col.g, col.b, std::max(1, (int)(f * path_alpha)));
+
+                ctx->setLineWidth(path_w + (add_w) * f);
+                ctx->setStrokeStyle(color);
+                ctx->strokePath(path, i, i1);
+            }
+        };
+
+        drawTrail(trail_w, 75);
+        drawTrail(trail_w * 1.5, 10);
+        drawTrail(trail_w * 3, 5);
+    }
+}
+
+template<class T>
+void SimPlot<T>::draw(Viewport* ctx, int cur_iter, double path_w, double trail_w) const
+{
+    for (int i = 0; i < (int)paths.size(); i++)
+        drawPath(ctx, paths[i], bodyColor(i), cur_iter, path_w, trail_w);
+}
+
+template<class T> template<class SimT>
+int SimPlot<T>::plot(const SimEnv<T>& env, const SimT& start, SimKeyframes<SimT>* keyframes)
+{
+    SimT s = start;
+
+    clear();
+    if (keyframes)
+        keyframes->clear();
+
+    for (int i = 0; i < env.max_iter; i++)
+    {
+        if (i % stride == 0)
+            recordPositions(s);
+
+        if (keyframes && i % keyframes->getInterval() == 0)
+            keyframes->record(s);
+
+        s.progress(env);
+        if (i % env.escape_freq == 0 && (int)s.stability().type & (int)StopResult::ABORT_MASK)
+            break;
+    }
+
+    if (keyframes)
+        keyframes->finish(s.curIter());
+
+    return s.curIter();
+}
+
+SIM_END;
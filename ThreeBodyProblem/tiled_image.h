@@ -0,0 +1,62 @@
+#pragma once
+#include <bitloop.h>
+#include <memory>
+
+SIM_BEG;
+
+using namespace bl;
+
+/// ─────── TiledWorldImage ───────
+//
+// Scan bitmap split into TILE x TILE raster tiles, each its own WorldImageT.
+// setPixel() only marks the owning tile dirty, so a frame that receives a few
+// scan rows re-uploads those tiles instead of the whole raster, and unchanged
+// tiles keep their cached image. The scene only needs to redraw when
+// takeDirty() reports changes, which keeps large rasters (1024^2 and up) from
+// competing with the scan for the scene thread.
+
+template<class T>
+class TiledWorldImage
+{
+public:
+
+    static constexpr int TILE = 64;
+
+    void setCamera(CameraInfo& camera);
+    void setRasterSize(int w, int h);   // reallocates (and clears) on change
+    void setStageRect(f64 x, f64 y, f64 w, f64 h);
+
+    void setPixel(int x, int y, Color c);
+    void clear(Color c = Color(0, 0, 0, 0));
+
+    // true if any tile changed since the last call (clears the flags)
+    bool takeDirty();
+    int  dirtyTiles() const { return dirty_count; }
+
+    void draw(Viewport* ctx) const;
+
+    int width() const  { return raster_w; }
+    int height() const { return raster_h; }
+
+private:
+
+    struct Tile
+    {
+        WorldImageT<T> image;
+        int x0 = 0, y0 = 0; // raster offset
+        int w = 0, h = 0;
+        bool dirty = false;
+    };
+
+    std::vector<std::unique_ptr<Tile>> tiles;
+    int cols = 0, rows = 0;
+    int raster_w = 0, raster_h = 0;
+    int dirty_count = 0;
+    CameraInfo* camera = nullptr;
+
+    Tile& tileAt(int x, int y) { return *tiles[(y / TILE) * cols + (x / TILE)]; }
+};
+
+SIM_END;
+
+#include "tiled_image.hpp"
@@ -0,0 +1,110 @@
+#include <bitloop.h>
+
+SIM_BEG;
+using namespace bl;
+
+template<class T>
+void TiledWorldImage<T>::setCamera(CameraInfo& cam)
+{
+    camera = &cam;
+    for (auto& tile : tiles)
+        tile->image.setCamera(cam);
+}
+
+template<class T>
+void TiledWorldImage<T>::setRasterSize(int w, int h)
+{
+    w = std::max(1, w);
+    h = std::max(1, h);
+    if (w == raster_w && h == raster_h)
+        return;
+
+    raster_w = w;
+    raster_h = h;
+    cols = (w + TILE - 1) / TILE;
+    rows = (h + TILE - 1) / TILE;
+
+    tiles.clear();
+    tiles.reserve((size_t)cols * rows);
+    for (int ty = 0; ty < rows; ty++)
+    {
+        for (int tx = 0; tx < cols; tx++)
+        {
+            auto tile = std::make_unique<Tile>();
+            tile->x0 = tx * TILE;
+            tile->y0 = ty * TILE;
+            tile->w = std::min(TILE, w - tile->x0);
+            tile->h = std::min(TILE, h - tile->y0);
+            tile->image.setRasterSize(tile->w, tile->h);
+            if (camera)
+                tile->image.setCamera(*camera);
+            tiles.push_back(std::move(tile));
+        }
+    }
+    dirty_count = (int)tiles.size();
+    for (auto& tile : tiles)
+        tile->dirty = true;
+}
+
+template<class T>
+void TiledWorldImage<T>::setStageRect(f64 x, f64 y, f64 w, f64 h)
+{
+    // each tile covers its share of the stage rect
+    const f64 sx = w / (f64)raster_w;
+    const f64 sy = h / (f64)raster_h;
+    for (auto& tile : tiles)
+        tile->image.setStageRect(x + tile->x0 * sx, y + tile->y0 * sy, tile->w * sx, tile->h * sy);
+}
+
+template<class T>
+void TiledWorldImage<T>::setPixel(int x, int y, Color c)
+{
+    if (x < 0 || y < 0 || x >= raster_w || y >= raster_h)
+        return;
+
+    Tile& tile = tileAt(x, y);
+    tile.image.setPixel(x - tile.x0, y - tile.y0, c);
+    if (!tile.dirty)
+    {
+        tile.dirty = true;
+        dirty_count++;
+    }
+}
+
+template<class T>
+void TiledWorldImage<T>::clear(Color c)
+{
+    for (auto& tile : tiles)
+    {
+        for (int y = 0; y < tile->h; y++)
+            for (int x = 0; x < tile->w; x++)
+                tile->image.setPixel(x, y, c);
+
+        if (!tile->dirty)
+        {
+            tile->dirty = true;
+            dirty_count++;
+        }
+    }
+}
+
+template<class T>
+bool TiledWorldImage<T>::takeDirty()
+{
+    if (dirty_count == 0)
+        return false;
+
+    for (auto& tile : tiles)
+        tile->dirty = false;
+    dirty_count = 0;
+    return true;
+}
+
+template<class T>
+void TiledWorldImage<T>::draw(Viewport* ctx) const
+{
+    for (const auto& tile : tiles)
+        ctx->drawImage(tile->image);
+}
+
+SIM_END;